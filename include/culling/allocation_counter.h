@@ -0,0 +1,154 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef ALLOCATION_COUNTER_H_
+#define ALLOCATION_COUNTER_H_
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace pcl
+{
+/** \brief The number of heap allocations made by the program. It is only counted in programs
+    * that install the allocation hooks, by defining CULLING_ALLOCATION_HOOKS in exactly one
+    * source file before including this header, and is 0 otherwise. With glibc the hooks replace
+    * malloc, calloc, realloc, memalign, posix_memalign and aligned_alloc, so operator new and
+    * Eigen::aligned_allocator, which the point clouds use, are both counted; elsewhere only
+    * operator new is.
+    *
+    * \code
+    * #define CULLING_ALLOCATION_HOOKS
+    * #include <culling/allocation_counter.h>
+    * \endcode
+    */
+inline std::atomic<size_t>& allocationCounter()
+{
+    static std::atomic<size_t> counter(0);
+    return (counter);
+}
+
+/** \brief The number of heap allocations made by the calling thread, see allocationCounter (). */
+inline size_t& threadAllocationCounter()
+{
+    static thread_local size_t counter = 0;
+    return (counter);
+}
+
+/** \brief Returns the number of heap allocations so far, see allocationCounter (). */
+inline size_t getAllocationCount()
+{
+    return (allocationCounter().load(std::memory_order_relaxed));
+}
+
+/** \brief Returns the number of heap allocations of the calling thread so far. */
+inline size_t getThreadAllocationCount()
+{
+    return (threadAllocationCounter());
+}
+
+/** \brief Counts one heap allocation. */
+inline void countAllocation()
+{
+    allocationCounter().fetch_add(1, std::memory_order_relaxed);
+    ++threadAllocationCounter();
+}
+}  // namespace pcl
+#endif
+
+// outside of the include guard, so the hooks are installed wherever the macro is defined
+#if defined(CULLING_ALLOCATION_HOOKS) && !defined(ALLOCATION_HOOKS_H_)
+#define ALLOCATION_HOOKS_H_
+#ifdef __GLIBC__
+#include <malloc.h>
+// the allocator of the C library stays reachable under these names; operator new and
+// Eigen::aligned_malloc both end up in the functions below
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) __THROW
+{
+    pcl::countAllocation();
+    return (__libc_malloc(size));
+}
+
+void* calloc(size_t count, size_t size) __THROW
+{
+    pcl::countAllocation();
+    return (__libc_calloc(count, size));
+}
+
+void* realloc(void* p, size_t size) __THROW
+{
+    pcl::countAllocation();
+    return (__libc_realloc(p, size));
+}
+
+void* memalign(size_t alignment, size_t size) __THROW
+{
+    pcl::countAllocation();
+    return (__libc_memalign(alignment, size));
+}
+
+void* aligned_alloc(size_t alignment, size_t size) __THROW
+{
+    pcl::countAllocation();
+    return (__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void** p, size_t alignment, size_t size) __THROW
+{
+    pcl::countAllocation();
+    *p = __libc_memalign(alignment, size);
+    return (*p || !size ? 0 : ENOMEM);
+}
+}
+#else
+void* operator new(std::size_t size)
+{
+    pcl::countAllocation();
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return (p);
+}
+
+void* operator new[](std::size_t size)
+{
+    return (operator new(size));
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+#endif
+#endif
@@ -0,0 +1,201 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef COVERAGE_ACCUMULATOR_H_
+#define COVERAGE_ACCUMULATOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace pcl
+{
+/** \brief Coverage of the occupied voxels of a model over a sequence of views.
+    * Every voxel id (the index of the voxel centroid in the filtered model cloud) keeps the
+    * number of views that see it, so a view can be added or removed again at a cost
+    * proportional to the number of voxels it sees, and reports the voxels it covers first or
+    * leaves uncovered.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::CoverageAccumulator coverage (num_model_voxels);
+    * std::vector<int> newly_covered;
+    * int view = coverage.addView (visible_voxel_ids, newly_covered);
+    * float percentage = coverage.getCoveragePercent ();
+    * coverage.removeView (view, uncovered);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+class CoverageAccumulator
+{
+  public:
+    /** \brief Empty constructor. */
+    CoverageAccumulator() : stamp_(0), covered_(0)
+    {
+    }
+
+    /** \brief Creates an accumulator without views over a number of voxel ids.
+        * \param[in] num_voxels the number of voxel ids
+        */
+    explicit CoverageAccumulator(size_t num_voxels) : stamp_(0), covered_(0)
+    {
+        resize(num_voxels);
+    }
+
+    /** \brief Sets the number of voxel ids and removes all views.
+        * \param[in] num_voxels the number of voxel ids
+        */
+    inline void resize(size_t num_voxels)
+    {
+        counts_.assign(num_voxels, 0);
+        stamps_.assign(num_voxels, 0);
+        stamp_ = 0;
+        views_.clear();
+        removed_.clear();
+        covered_ = 0;
+    }
+
+    /** \brief Removes all views. */
+    inline void clear()
+    {
+        resize(counts_.size());
+    }
+
+    /** \brief Adds the voxels seen from a view.
+        * \param[in] voxel_ids the ids of the voxels seen, may repeat and contain -1 for none
+        * \param[out] out_newly_covered the voxels no other view covered before
+        * \return the id of the view, used to remove it again
+        */
+    inline int addView(const std::vector<int>& voxel_ids, std::vector<int>& out_newly_covered)
+    {
+        out_newly_covered.clear();
+        views_.push_back(std::vector<int>());
+        removed_.push_back(false);
+        std::vector<int>& view = views_.back();
+        nextStamp();
+        for (size_t i = 0; i < voxel_ids.size(); ++i)
+        {
+            int id = voxel_ids[i];
+            if (id < 0 || stamps_[id] == stamp_)
+                continue;
+            stamps_[id] = stamp_;
+            view.push_back(id);
+            if (counts_[id]++ == 0)
+                out_newly_covered.push_back(id);
+        }
+        covered_ += out_newly_covered.size();
+        return static_cast<int>(views_.size()) - 1;
+    }
+
+    /** \brief Removes a view added before.
+        * \param[in] view_id the id returned by addView ()
+        * \param[out] out_uncovered the voxels no remaining view covers
+        * \return 0 on success, -1 if the view does not exist or was already removed
+        */
+    inline int removeView(int view_id, std::vector<int>& out_uncovered)
+    {
+        out_uncovered.clear();
+        if (view_id < 0 || view_id >= static_cast<int>(views_.size()) || removed_[view_id])
+            return (-1);
+        std::vector<int>& view = views_[view_id];
+        for (size_t i = 0; i < view.size(); ++i)
+            if (--counts_[view[i]] == 0)
+                out_uncovered.push_back(view[i]);
+        covered_ -= out_uncovered.size();
+        std::vector<int>().swap(view);
+        removed_[view_id] = true;
+        return (0);
+    }
+
+    /** \brief Returns the number of voxels a view would cover first, without adding it.
+        * \param[in] voxel_ids the ids of the voxels seen, may repeat and contain -1 for none
+        */
+    inline size_t getMarginalGain(const std::vector<int>& voxel_ids)
+    {
+        size_t gain = 0;
+        nextStamp();
+        for (size_t i = 0; i < voxel_ids.size(); ++i)
+        {
+            int id = voxel_ids[i];
+            if (id < 0 || stamps_[id] == stamp_)
+                continue;
+            stamps_[id] = stamp_;
+            if (counts_[id] == 0)
+                ++gain;
+        }
+        return (gain);
+    }
+
+    /** \brief Returns the number of voxels seen by at least one view. */
+    inline size_t getCoveredCount()
+    {
+        return (covered_);
+    }
+
+    /** \brief Returns the percentage of the voxels seen by at least one view. */
+    inline float getCoveragePercent()
+    {
+        if (counts_.empty())
+            return (0);
+        return (100.0f * static_cast<float>(covered_) / static_cast<float>(counts_.size()));
+    }
+
+    /** \brief Returns the number of views that see a voxel.
+        * \param[in] voxel_id the voxel id
+        */
+    inline unsigned int getViewCount(int voxel_id)
+    {
+        return (counts_[voxel_id]);
+    }
+
+    /** \brief Returns the number of views added, including removed ones. */
+    inline size_t getNumberOfViews()
+    {
+        return (views_.size());
+    }
+
+  protected:
+    /** \brief Starts a new stamp for the duplicate check of a view. */
+    inline void nextStamp()
+    {
+        if (++stamp_ == 0)
+        {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            stamp_ = 1;
+        }
+    }
+
+    // number of views seeing every voxel and the stamp of the last view that listed it
+    std::vector<unsigned int> counts_;
+    std::vector<unsigned int> stamps_;
+    unsigned int stamp_;
+
+    // unique voxel ids of every view, and whether it was removed
+    std::vector<std::vector<int> > views_;
+    std::vector<bool> removed_;
+
+    // number of voxels with a non zero count
+    size_t covered_;
+};
+}  // namespace pcl
+#endif
@@ -0,0 +1,76 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef CULLING_ENGINE_H_
+#define CULLING_ENGINE_H_
+
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/PoseArray.h>
+#include <boost/shared_ptr.hpp>
+
+#include <pcl/point_cloud.h>
+#include <string>
+#include <vector>
+
+/** \brief The queries every culling engine answers the same way, whichever backend runs them:
+  * OcclusionCulling with the scalar, interleaved or threaded backend on the CPU, or
+  * OcclusionCullingGPU, the accelerator backend of the CUDA build. createCullingEngine ()
+  * picks the engine from the culling_backend parameter, so the backend is chosen per machine
+  * without code changes.
+  *
+  * \code
+  * CullingEngine<pcl::PointXYZ>::Ptr engine = createCullingEngine<pcl::PointXYZ>(nh, cloud);
+  * engine->extractVisibleSurface(pose, visibleCloud);
+  * float coverage = engine->calcCoveragePercent(visibleCloudPtr);
+  * \endcode
+  */
+template <typename PointInT>
+class CullingEngine
+{
+  public:
+    typedef boost::shared_ptr<CullingEngine<PointInT> > Ptr;
+
+    virtual ~CullingEngine()
+    {
+    }
+
+    /** \brief Writes the points of the model seen from a sensor location to visibleCloud. */
+    virtual void extractVisibleSurface(const geometry_msgs::Pose& location,
+                                       pcl::PointCloud<PointInT>& visibleCloud) = 0;
+
+    /** \brief Returns the percentage of the model voxels a cloud covers. */
+    virtual float calcCoveragePercent(typename pcl::PointCloud<PointInT>::Ptr cloud_filtered) = 0;
+
+    /** \brief Returns the average depth error of a cloud seen from a sensor pose. */
+    virtual double calcAvgAccuracy(const pcl::PointCloud<PointInT>& pointCloud,
+                                   const geometry_msgs::Pose& cameraPose) = 0;
+
+    /** \brief Sets the largest and smallest depth errors over the views of all sensors. */
+    virtual void SSMaxMinAccuracy(const std::vector<geometry_msgs::PoseArray>& sensorsPoses) = 0;
+
+    /** \brief Returns the entropy of the last visible surface, 0 if it was not computed. */
+    virtual float getViewEntropy() = 0;
+
+    /** \brief Returns the culling_backend name of the backend that runs the queries. */
+    virtual std::string getBackendName() = 0;
+};
+
+#endif
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef CULLING_ENGINE_FACTORY_H_
+#define CULLING_ENGINE_FACTORY_H_
+
+#include <culling/culling_engine.h>
+#include <culling/occlusion_culling.h>
+#ifdef CULLING_GPU
+#include <culling/occlusion_culling_gpu.h>
+#endif
+#include <stdexcept>
+#include <string>
+
+// the accelerator backend is OcclusionCullingGPU, whose filters only take pcl::PointXYZ
+template <typename PointInT>
+typename CullingEngine<PointInT>::Ptr createAcceleratorEngine(
+    ros::NodeHandle& n, typename pcl::PointCloud<PointInT>::Ptr& cloudPtr)
+{
+#ifdef CULLING_GPU
+    ROS_FATAL("Culling backend accelerator only culls pcl::PointXYZ clouds");
+#else
+    ROS_FATAL("Culling backend accelerator needs the CUDA build");
+#endif
+    throw std::invalid_argument("culling_backend accelerator is not available");
+}
+
+#ifdef CULLING_GPU
+template <>
+inline CullingEngine<pcl::PointXYZ>::Ptr createAcceleratorEngine<pcl::PointXYZ>(
+    ros::NodeHandle& n, pcl::PointCloud<pcl::PointXYZ>::Ptr& cloudPtr)
+{
+    return (CullingEngine<pcl::PointXYZ>::Ptr(new OcclusionCullingGPU(n, cloudPtr)));
+}
+#endif
+
+/** \brief Creates the culling engine of a model that the culling_backend parameter selects:
+  * "accelerator" for OcclusionCullingGPU, which needs the CUDA build and pcl::PointXYZ, and
+  * OcclusionCulling for the CPU backends. An unknown or unavailable backend throws
+  * std::invalid_argument.
+  * \param[in] n the node handle the parameters are read from
+  * \param[in] cloudPtr the model
+  */
+template <typename PointInT>
+typename CullingEngine<PointInT>::Ptr createCullingEngine(
+    ros::NodeHandle& n, typename pcl::PointCloud<PointInT>::Ptr& cloudPtr)
+{
+    std::string backend;
+    n.param<std::string>("culling_backend", backend, "interleaved");
+    if (backend == "accelerator")
+        return (createAcceleratorEngine<PointInT>(n, cloudPtr));
+    return (typename CullingEngine<PointInT>::Ptr(new OcclusionCulling<PointInT>(n, cloudPtr)));
+}
+
+#endif
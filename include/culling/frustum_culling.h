@@ -180,6 +180,26 @@ class FrustumCullingTT : public FilterIndices<PointInT>
     {
         return (fp_dist_);
     }
+
+    /** \brief Allocates the indices for an input of up to num_points points, so that
+        * filtering it does not allocate.
+        * \param[in] num_points the largest number of input points
+        */
+    void reserve(size_t num_points);
+
+    /** \brief Computes the planes of the frustum at the camera pose, as filter () does. */
+    void computePlanes();
+
+    /** \brief Returns true if a point is inside the frustum of the last computePlanes () or
+        * filter () call, without the negative setting.
+        * \param[in] point the point
+        */
+    inline bool isInside(const PointInT &point) const
+    {
+        Eigen::Vector4f pt(point.x, point.y, point.z, 1.0f);
+        return ((pt.dot(pl_l_) <= 0) && (pt.dot(pl_r_) <= 0) && (pt.dot(pl_t_) <= 0) &&
+                (pt.dot(pl_b_) <= 0) && (pt.dot(pl_f_) <= 0) && (pt.dot(pl_n_) <= 0));
+    }
     //added part for debuging
     Eigen::Vector3f fp_tl;
     Eigen::Vector3f fp_tr;
@@ -194,6 +214,7 @@ class FrustumCullingTT : public FilterIndices<PointInT>
   protected:
     using PCLBase<PointInT>::input_;
     using PCLBase<PointInT>::indices_;
+    using PCLBase<PointInT>::fake_indices_;
     using Filter<PointInT>::filter_name_;
     using FilterIndices<PointInT>::negative_;
     using FilterIndices<PointInT>::keep_organized_;
@@ -222,6 +243,10 @@ class FrustumCullingTT : public FilterIndices<PointInT>
     float np_dist_;
     /** \brief Far plane distance */
     float fp_dist_;
+    /** \brief Indices of the points inside the frustum, kept across calls to filter () */
+    std::vector<int> frustum_indices_;
+    /** \brief Near, far, top, bottom, right and left planes of the frustum */
+    Eigen::Vector4f pl_n_, pl_f_, pl_t_, pl_b_, pl_r_, pl_l_;
 
   public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
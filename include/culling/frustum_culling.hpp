@@ -46,12 +46,28 @@
 #include <pcl/common/io.h>
 #include <vector>
 
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::FrustumCullingTT<PointInT>::reserve(size_t num_points)
+{
+    if (!indices_)
+    {
+        indices_.reset(new std::vector<int>);
+        fake_indices_ = true;
+    }
+    if (fake_indices_)
+        indices_->reserve(num_points);
+    frustum_indices_.reserve(num_points);
+    if (extract_removed_indices_)
+        removed_indices_->reserve(num_points);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 template <typename PointInT>
 void pcl::FrustumCullingTT<PointInT>::applyFilter(PointCloud &output)
 {
     //  std::cout<<"YES, this is a test \n\n";
-    std::vector<int> indices;
+    std::vector<int> &indices = frustum_indices_;
     if (keep_organized_)
     {
         bool temp = extract_removed_indices_;
@@ -78,14 +94,14 @@ void pcl::FrustumCullingTT<PointInT>::applyFilter(PointCloud &output)
 
 ///////////////////////////////////////////////////////////////////////////////
 template <typename PointInT>
-void pcl::FrustumCullingTT<PointInT>::applyFilter(std::vector<int> &indices)
+void pcl::FrustumCullingTT<PointInT>::computePlanes()
 {
-    Eigen::Vector4f pl_n;  // near plane
-    Eigen::Vector4f pl_f;  // far plane
-    Eigen::Vector4f pl_t;  // top plane
-    Eigen::Vector4f pl_b;  // bottom plane
-    Eigen::Vector4f pl_r;  // right plane
-    Eigen::Vector4f pl_l;  // left plane
+    Eigen::Vector4f &pl_n = pl_n_;  // near plane
+    Eigen::Vector4f &pl_f = pl_f_;  // far plane
+    Eigen::Vector4f &pl_t = pl_t_;  // top plane
+    Eigen::Vector4f &pl_b = pl_b_;  // bottom plane
+    Eigen::Vector4f &pl_r = pl_r_;  // right plane
+    Eigen::Vector4f &pl_l = pl_l_;  // left plane
 
     Eigen::Vector3f view = camera_pose_.block(
         0, 0, 3, 1);  // view vector for the camera  - first column of the rotation matrix
@@ -152,6 +168,13 @@ void pcl::FrustumCullingTT<PointInT>::applyFilter(std::vector<int> &indices)
     pl_l(3) = -T.dot(pl_l.block(0, 0, 3, 1));
     pl_t(3) = -T.dot(pl_t.block(0, 0, 3, 1));
     pl_b(3) = -T.dot(pl_b.block(0, 0, 3, 1));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::FrustumCullingTT<PointInT>::applyFilter(std::vector<int> &indices)
+{
+    computePlanes();
 
     if (extract_removed_indices_)
     {
@@ -163,10 +186,7 @@ void pcl::FrustumCullingTT<PointInT>::applyFilter(std::vector<int> &indices)
     for (size_t i = 0; i < indices_->size(); i++)
     {
         int idx = indices_->at(i);
-        Eigen::Vector4f pt(input_->points[idx].x, input_->points[idx].y, input_->points[idx].z,
-                           1.0f);
-        bool is_in_fov = (pt.dot(pl_l) <= 0) && (pt.dot(pl_r) <= 0) && (pt.dot(pl_t) <= 0) &&
-                         (pt.dot(pl_b) <= 0) && (pt.dot(pl_f) <= 0) && (pt.dot(pl_n) <= 0);
+        bool is_in_fov = isInside(input_->points[idx]);
         if (is_in_fov ^ negative_)
         {
             indices[indices_ctr++] = idx;
@@ -74,12 +74,16 @@ namespace pcl
    * \author Aravindhan K Krishnan
    * \ingroup filters
    */
-template <typename PointInT>
-class FrustumCullingGPU : public FilterIndices<PointInT>
+class FrustumCullingGPU : public FilterIndices<pcl::PointXYZ>
 {
-    typedef typename Filter<PointInT>::PointCloud PointCloud;
-    typedef typename PointCloud::Ptr PointCloudPtr;
-    typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+  public:
+    // the kernels only copy the x, y, z coordinates to the device
+    typedef pcl::PointXYZ PointInT;
+
+  private:
+    typedef Filter<PointInT>::PointCloud PointCloud;
+    typedef PointCloud::Ptr PointCloudPtr;
+    typedef PointCloud::ConstPtr PointCloudConstPtr;
 
   public:
     typedef boost::shared_ptr<FrustumCullingGPU> Ptr;
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef LATENCY_STATISTICS_H_
+#define LATENCY_STATISTICS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace pcl
+{
+/** \brief Latency percentiles of the last queries. The samples are kept in a ring buffer
+    * allocated by setWindowSize (), so adding a sample or reading a percentile never allocates.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::LatencyStatistics latency (10000);
+    * latency.add (seconds);
+    * double p99 = latency.getPercentile (0.99);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+class LatencyStatistics
+{
+  public:
+    /** \brief Empty constructor, only the count, mean and maximum are kept. */
+    LatencyStatistics()
+    {
+        reset();
+    }
+
+    /** \brief Creates empty statistics over a window of samples.
+        * \param[in] window_size the number of latest samples the percentiles are taken over
+        */
+    explicit LatencyStatistics(size_t window_size)
+    {
+        setWindowSize(window_size);
+    }
+
+    /** \brief Allocates the window and removes all samples.
+        * \param[in] window_size the number of latest samples the percentiles are taken over
+        */
+    inline void setWindowSize(size_t window_size)
+    {
+        samples_.assign(window_size, 0);
+        sorted_.assign(window_size, 0);
+        reset();
+    }
+
+    /** \brief Returns the number of latest samples the percentiles are taken over. */
+    inline size_t getWindowSize() const
+    {
+        return (samples_.size());
+    }
+
+    /** \brief Removes all samples. */
+    inline void reset()
+    {
+        count_ = 0;
+        next_ = 0;
+        sum_ = 0;
+        max_ = 0;
+    }
+
+    /** \brief Adds a sample.
+        * \param[in] seconds the latency of a query
+        */
+    inline void add(double seconds)
+    {
+        ++count_;
+        sum_ += seconds;
+        if (max_ < seconds)
+            max_ = seconds;
+        if (!samples_.empty())
+        {
+            samples_[next_] = seconds;
+            next_ = (next_ + 1 == samples_.size()) ? 0 : next_ + 1;
+        }
+    }
+
+    /** \brief Returns the number of samples added since the last reset. */
+    inline size_t getCount() const
+    {
+        return (count_);
+    }
+
+    /** \brief Returns the mean latency, or 0 without samples. */
+    inline double getMean() const
+    {
+        return (count_ > 0 ? sum_ / count_ : 0);
+    }
+
+    /** \brief Returns the largest latency since the last reset. */
+    inline double getMax() const
+    {
+        return (max_);
+    }
+
+    /** \brief Returns the nearest rank percentile of the samples in the window.
+        * \param[in] fraction the percentile as a fraction, e.g. 0.99 for p99
+        * \return the latency, or 0 without samples in the window
+        */
+    inline double getPercentile(double fraction)
+    {
+        size_t n = std::min(count_, samples_.size());
+        if (n == 0)
+            return (0);
+        size_t rank = static_cast<size_t>(std::ceil(fraction * n));
+        rank = std::max<size_t>(1, std::min(rank, n));
+        std::copy(samples_.begin(), samples_.begin() + n, sorted_.begin());
+        std::nth_element(sorted_.begin(), sorted_.begin() + (rank - 1), sorted_.begin() + n);
+        return (sorted_[rank - 1]);
+    }
+
+  protected:
+    size_t count_;
+    size_t next_;
+    double sum_;
+    double max_;
+
+    // ring buffer of the latest samples and the buffer they are ranked in
+    std::vector<double> samples_;
+    std::vector<double> sorted_;
+};
+}  // namespace pcl
+#endif
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef OCCLUSION_BACKEND_H_
+#define OCCLUSION_BACKEND_H_
+
+#include <culling/voxel_grid_occlusion_estimation.h>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+/** \brief Strategy that estimates the state (free = 0, occluded = 1, no intersection = -1) of
+    * a batch of target voxels of a VoxelGridOcclusionEstimationT. Every backend gives the
+    * states of VoxelGridOcclusionEstimationT::occlusionEstimation () for a single voxel, so
+    * the backend can be chosen per machine at runtime with createOcclusionBackend ().
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::OcclusionBackend<PointInT>::Ptr backend =
+    *   pcl::createOcclusionBackend<PointInT> ("threaded", 1);
+    * grid.initializeVoxelGrid ();
+    * backend->estimate (grid, states, target_voxels);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+template <typename PointInT>
+class OcclusionBackend
+{
+  public:
+    typedef boost::shared_ptr<OcclusionBackend<PointInT> > Ptr;
+    typedef std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > VoxelVector;
+
+    /** \brief Destructor. */
+    virtual ~OcclusionBackend()
+    {
+    }
+
+    /** \brief Returns the state of every target voxel.
+        * \param[in] grid the initialized voxel grid with the sensor origin set
+        * \param[out] out_states the state of each target voxel
+        * \param[in] in_target_voxels the target voxel coordinates (i, j, k)
+        * \return 0 on success, -1 if the voxel grid was not initialized
+        */
+    virtual int estimate(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                         std::vector<int>& out_states, const VoxelVector& in_target_voxels) = 0;
+
+    /** \brief Returns the average number of rays in flight during the last estimate ().
+        * \param[in] grid the voxel grid of the last estimate ()
+        * \param[in] num_targets the number of target voxels of the last estimate ()
+        */
+    virtual double getRayParallelism(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                                     size_t num_targets) = 0;
+
+    /** \brief Returns the name the backend is selected with. */
+    virtual std::string getName() = 0;
+};
+
+/** \brief Reference backend, traverses the rays one after the other. */
+template <typename PointInT>
+class ScalarOcclusionBackend : public OcclusionBackend<PointInT>
+{
+  public:
+    typedef typename OcclusionBackend<PointInT>::VoxelVector VoxelVector;
+
+    virtual int estimate(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                         std::vector<int>& out_states, const VoxelVector& in_target_voxels);
+
+    virtual double getRayParallelism(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                                     size_t num_targets)
+    {
+        return (num_targets > 0 ? 1.0 : 0.0);
+    }
+
+    virtual std::string getName()
+    {
+        return ("scalar");
+    }
+};
+
+/** \brief Backend that advances groups of rays in turn and prefetches the voxel each ray
+    * visits next, see VoxelGridOcclusionEstimationT::occlusionEstimation ().
+    */
+template <typename PointInT>
+class InterleavedOcclusionBackend : public OcclusionBackend<PointInT>
+{
+  public:
+    typedef typename OcclusionBackend<PointInT>::VoxelVector VoxelVector;
+
+    /** \brief Constructor.
+        * \param[in] ray_group_size the number of rays in flight
+        */
+    explicit InterleavedOcclusionBackend(int ray_group_size) : ray_group_size_(ray_group_size)
+    {
+    }
+
+    virtual int estimate(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                         std::vector<int>& out_states, const VoxelVector& in_target_voxels);
+
+    virtual double getRayParallelism(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                                     size_t num_targets)
+    {
+        return (grid.getMemoryLevelParallelism());
+    }
+
+    virtual std::string getName()
+    {
+        return ("interleaved");
+    }
+
+  protected:
+    int ray_group_size_;
+};
+
+/** \brief Backend that traverses the rays on all OpenMP threads. */
+template <typename PointInT>
+class ThreadedOcclusionBackend : public OcclusionBackend<PointInT>
+{
+  public:
+    typedef typename OcclusionBackend<PointInT>::VoxelVector VoxelVector;
+
+    virtual int estimate(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                         std::vector<int>& out_states, const VoxelVector& in_target_voxels);
+
+    /** \brief Returns the number of threads the rays were spread over, each having one ray
+        * in flight.
+        */
+    virtual double getRayParallelism(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                                     size_t num_targets);
+
+    virtual std::string getName()
+    {
+        return ("threaded");
+    }
+};
+
+/** \brief Creates a backend by name: "scalar", "interleaved" or "threaded". The
+    * "accelerator" backend of the CUDA build is a whole engine, see createCullingEngine ().
+    * \param[in] name the name of the backend
+    * \param[in] ray_group_size the number of rays in flight of the interleaved backend
+    * \return the backend, or an empty pointer for any other name
+    */
+template <typename PointInT>
+typename OcclusionBackend<PointInT>::Ptr createOcclusionBackend(const std::string& name,
+                                                                int ray_group_size);
+}  // namespace pcl
+#include "culling/occlusion_backend.hpp"
+#endif
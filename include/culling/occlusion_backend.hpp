@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef OCCLUSION_BACKEND_HPP_
+#define OCCLUSION_BACKEND_HPP_
+
+#include <culling/occlusion_backend.h>
+#include <culling/parallel_threads.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::ScalarOcclusionBackend<PointInT>::estimate(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                                                    std::vector<int>& out_states,
+                                                    const VoxelVector& in_target_voxels)
+{
+    if (!grid.isInitialized())
+    {
+        PCL_ERROR("Voxel grid not initialized; call initializeVoxelGrid () first! \n");
+        return -1;
+    }
+    out_states.assign(in_target_voxels.size(), -1);
+    for (size_t i = 0; i < in_target_voxels.size(); ++i)
+    {
+        int state;
+        if (grid.occlusionEstimation(state, in_target_voxels[i]) == 0)
+            out_states[i] = state;
+    }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::InterleavedOcclusionBackend<PointInT>::estimate(
+    VoxelGridOcclusionEstimationT<PointInT>& grid, std::vector<int>& out_states,
+    const VoxelVector& in_target_voxels)
+{
+    return (grid.occlusionEstimation(out_states, in_target_voxels, ray_group_size_));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::ThreadedOcclusionBackend<PointInT>::estimate(VoxelGridOcclusionEstimationT<PointInT>& grid,
+                                                      std::vector<int>& out_states,
+                                                      const VoxelVector& in_target_voxels)
+{
+    if (!grid.isInitialized())
+    {
+        PCL_ERROR("Voxel grid not initialized; call initializeVoxelGrid () first! \n");
+        return -1;
+    }
+    // the traversal of a single ray only reads the voxel grid, so the rays are independent
+    int num_targets = static_cast<int>(in_target_voxels.size());
+    out_states.assign(num_targets, -1);
+    int num_threads = getParallelThreads();
+    if (num_threads > 1)
+    {
+#pragma omp parallel for schedule(dynamic, 64) num_threads(num_threads)
+        for (int i = 0; i < num_targets; ++i)
+        {
+            int state;
+            if (grid.occlusionEstimation(state, in_target_voxels[i]) == 0)
+                out_states[i] = state;
+        }
+    }
+    else
+        for (int i = 0; i < num_targets; ++i)
+        {
+            int state;
+            if (grid.occlusionEstimation(state, in_target_voxels[i]) == 0)
+                out_states[i] = state;
+        }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+double pcl::ThreadedOcclusionBackend<PointInT>::getRayParallelism(
+    VoxelGridOcclusionEstimationT<PointInT>& grid, size_t num_targets)
+{
+    return (static_cast<double>(std::min(static_cast<size_t>(getParallelThreads()), num_targets)));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+typename pcl::OcclusionBackend<PointInT>::Ptr pcl::createOcclusionBackend(
+    const std::string& name, int ray_group_size)
+{
+    typedef typename OcclusionBackend<PointInT>::Ptr Ptr;
+    if (name == "scalar")
+        return (Ptr(new ScalarOcclusionBackend<PointInT>));
+    if (name == "interleaved")
+        return (Ptr(new InterleavedOcclusionBackend<PointInT>(ray_group_size)));
+    if (name == "threaded")
+        return (Ptr(new ThreadedOcclusionBackend<PointInT>));
+    return (Ptr());
+}
+
+#endif
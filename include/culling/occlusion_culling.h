@@ -35,8 +35,19 @@
 #include "ros/ros.h"
 
 //PCL
+#include <culling/allocation_counter.h>
+#include <culling/coverage_accumulator.h>
+#include <culling/culling_engine.h>
 #include <culling/frustum_culling.h>
+#include <culling/occlusion_backend.h>
+#include <culling/occlusion_culling_context.h>
+#include <culling/point_set_operations.h>
+#include <culling/view_statistics.h>
+#include <culling/visible_surface_batch.h>
+#include <culling/visibility_field.h>
+#include <culling/visibility_heatmap.h>
 #include <culling/voxel_grid_occlusion_estimation.h>
+#include <culling/voxel_set.h>
 #include <geometry_msgs/Point32.h>
 #include <geometry_msgs/PoseArray.h>
 #include <pcl/common/eigen.h>
@@ -47,10 +58,46 @@
 #include <pcl/range_image/range_image.h>
 #include <pcl_conversions/pcl_conversions.h>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 #include "utils.h"
 
+namespace pcl
+{
+namespace detail
+{
+/** \brief Whether PointInT carries colour, in which case voxel centroids average all the fields
+    * and the debug occupancy grid is painted. Geometry-only types skip both.
+    */
+template <typename PointInT>
+struct HasColor
+{
+    static const bool value = pcl::traits::has_field<PointInT, pcl::fields::rgb>::value ||
+                              pcl::traits::has_field<PointInT, pcl::fields::rgba>::value;
+};
+
+/** \brief Paints a debug point; a no-op for geometry-only point types. */
+template <typename PointInT, bool Colored = HasColor<PointInT>::value>
+struct DebugColor
+{
+    static inline void set(PointInT&, uint8_t, uint8_t, uint8_t) {}
+};
+
 template <typename PointInT>
-class OcclusionCulling
+struct DebugColor<PointInT, true>
+{
+    static inline void set(PointInT& point, uint8_t r, uint8_t g, uint8_t b)
+    {
+        point.r = r;
+        point.g = g;
+        point.b = b;
+    }
+};
+}  // namespace detail
+}  // namespace pcl
+
+template <typename PointInT>
+class OcclusionCulling : public CullingEngine<PointInT>
 {
   public:
     ros::NodeHandle nh;
@@ -60,48 +107,125 @@ class OcclusionCulling
     typename pcl::PointCloud<PointInT>::Ptr cloudCopy;
     typename pcl::PointCloud<PointInT>::Ptr filteredCloud;
     typename pcl::PointCloud<PointInT>::Ptr occlusionFreeCloud;
-    typename pcl::PointCloud<PointInT>::Ptr frustumCloud;
     typename pcl::PointCloud<PointInT>::Ptr rayCloud;
-    typename pcl::PointCloud<PointInT>::Ptr occupancyGrid;
 
     pcl::PointCloud<PointInT> freeCloud;
     double voxelRes, originalVoxelsSize;
     double sensorHorFOV, sensorVerFOV, sensorNearLimit, sensorFarLimit, leafSize;
-    double id;
+    int rayInterleave;
+    std::string cullingBackend;
+    std::string executionMode;
+    typename pcl::OcclusionBackend<PointInT>::Ptr occlusionBackend;
+    bool sortRays;
+    bool traverseFromSensor;
+    bool useVisibilityField;
+    bool useViewEntropy;
+    bool realTime;
+    int latencyWindow;
+    int batchThreads;
+    int visibilityFieldDirections;
+    std::string visibilityFieldFile;
+    pcl::VisibilityFieldT<PointInT> visibilityField;
     pcl::VoxelGridOcclusionEstimationT<PointInT> voxelFilterOriginal;
+    // (i,j,k) voxel of every model point
+    typename pcl::OcclusionBackend<PointInT>::VoxelVector pointVoxels;
+    // model voxel index of every model point, for the fused execution
+    std::vector<int> pointVoxelIds;
+    pcl::VoxelSet coveredVoxels;
+    pcl::CoverageAccumulator coverage;
     Eigen::Vector3i max_b1, min_b1;
-    pcl::FrustumCullingTT<PointInT> fc;
     double maxAccuracyError, minAccuracyError;
     bool AccuracyMaxSet;
     bool debugEnabled;
-    visualization_msgs::MarkerArray markerArray;
-    visualization_msgs::Marker rayLines;
-    sensor_msgs::PointCloud2 occupancyGridCloud;
+    // the context of the queries that do not bring their own, its frustum and occupancy grid
+    // clouds are also the frustumCloud and occupancyGrid of the model
+    OcclusionCullingContext<PointInT> defaultContext;
+    // the contexts of the threads of extractVisibleSurfaceBatch, kept across batches
+    std::vector<typename OcclusionCullingContext<PointInT>::Ptr> batchContexts;
+    typename pcl::PointCloud<PointInT>::Ptr frustumCloud;
+    typename pcl::PointCloud<PointInT>::Ptr occupancyGrid;
+    // the per-query members of the model before the contexts, kept as the members of the
+    // default context so that callers reading them see the last query without a context
+    pcl::FrustumCullingTT<PointInT>& fc;
+    pcl::ViewStatistics& viewStatistics;
+    double& rayParallelism;
+    float& viewEntropy;
+    std::vector<float>& pointEntropies;
+    double& id;
+    visualization_msgs::MarkerArray& markerArray;
+    visualization_msgs::Marker& rayLines;
+    sensor_msgs::PointCloud2& occupancyGridCloud;
     //methods
     OcclusionCulling(ros::NodeHandle& n, std::string modelName);
     OcclusionCulling(ros::NodeHandle& n, typename pcl::PointCloud<PointInT>::Ptr& cloudPtr);
     ~OcclusionCulling();
 
     pcl::PointCloud<PointInT> extractVisibleSurface(geometry_msgs::Pose location);
+    virtual void extractVisibleSurface(const geometry_msgs::Pose& location,
+                                       pcl::PointCloud<PointInT>& visibleCloud);
+    void extractVisibleSurface(const geometry_msgs::Pose& location,
+                               OcclusionCullingContext<PointInT>& context,
+                               pcl::PointCloud<PointInT>& visibleCloud) const;
+    pcl::VisibleSurfaceBatch extractVisibleSurfaceBatch(
+        const std::vector<geometry_msgs::Pose>& locations);
+    void extractVisibleSurfaceBatch(const std::vector<geometry_msgs::Pose>& locations,
+                                    pcl::VisibleSurfaceBatch& batch);
+    void cullVisibleSurface(const geometry_msgs::Pose& location,
+                            OcclusionCullingContext<PointInT>& context,
+                            pcl::PointCloud<PointInT>& visibleCloud) const;
+    typename OcclusionCullingContext<PointInT>::Ptr createContext() const;
+    void initializeContext(OcclusionCullingContext<PointInT>& context) const;
+    bool isFused() const;
+    void frustumVoxelSweep(OcclusionCullingContext<PointInT>& context) const;
     pcl::PointCloud<PointInT> getFrustumCloud();
+    typename pcl::PointCloud<PointInT>::ConstPtr getFrustumCloudPtr();
+    pcl::PointCloud<pcl::PointXYZI> visibilityHeatmap(int numDirections, double padding);
     visualization_msgs::MarkerArray getFOV();
     sensor_msgs::PointCloud2 getOccupancyGridCloud();
     visualization_msgs::Marker getRays();
     //    float calcCoveragePercent(geometry_msgs::Pose location);
     void initialize();
-    float calcCoveragePercent(typename pcl::PointCloud<PointInT>::Ptr cloud_filtered);
-    double calcAvgAccuracy(pcl::PointCloud<PointInT> pointCloud);
-    double calcAvgAccuracy(pcl::PointCloud<PointInT> pointCloud, geometry_msgs::Pose cameraPose);
-    void transformPointMatVec(tf::Vector3 translation, tf::Matrix3x3 rotation,
-                              geometry_msgs::Point32 in, geometry_msgs::Point32& out);
-    pcl::PointCloud<PointInT> pointCloudViewportTransform(pcl::PointCloud<PointInT> pointCloud,
-                                                          geometry_msgs::Pose cameraPose);
-    void SSMaxMinAccuracy(std::vector<geometry_msgs::PoseArray> sensorsPoses);
+    virtual float calcCoveragePercent(typename pcl::PointCloud<PointInT>::Ptr cloud_filtered);
+    float calcCoveragePercent(const pcl::VoxelSet& voxels);
+    int getModelVoxelId(const PointInT& point);
+    void markVoxels(const pcl::PointCloud<PointInT>& pointCloud, pcl::VoxelSet& voxels);
+    void getModelVoxelIds(const pcl::PointCloud<PointInT>& pointCloud, std::vector<int>& voxelIds);
+    int addViewCoverage(const pcl::PointCloud<PointInT>& visibleCloud,
+                        std::vector<int>& newlyCovered);
+    float removeViewCoverage(int viewId);
+    double calcAvgAccuracy(const pcl::PointCloud<PointInT>& pointCloud);
+    virtual double calcAvgAccuracy(const pcl::PointCloud<PointInT>& pointCloud,
+                                   const geometry_msgs::Pose& cameraPose);
+    void transformPointMatVec(const tf::Vector3& translation, const tf::Matrix3x3& rotation,
+                              const geometry_msgs::Point32& in, geometry_msgs::Point32& out);
+    pcl::PointCloud<PointInT> pointCloudViewportTransform(
+        const pcl::PointCloud<PointInT>& pointCloud, const geometry_msgs::Pose& cameraPose);
+    void pointCloudViewportTransform(const pcl::PointCloud<PointInT>& pointCloud,
+                                     const geometry_msgs::Pose& cameraPose,
+                                     pcl::PointCloud<PointInT>& transformedCloud);
+    void pointCloudViewportDepth(const pcl::PointCloud<PointInT>& pointCloud,
+                                 const geometry_msgs::Pose& cameraPose, std::vector<float>& depth);
+    Eigen::Matrix<float, 3, 4> viewportTransform(const geometry_msgs::Pose& cameraPose) const;
+    virtual void SSMaxMinAccuracy(const std::vector<geometry_msgs::PoseArray>& sensorsPoses);
+    virtual float getViewEntropy();
+    virtual std::string getBackendName();
+    void SSMaxMinAccuracy(
+        const std::vector<geometry_msgs::PoseArray>& sensorsPoses,
+        const std::vector<typename pcl::PointCloud<PointInT>::ConstPtr>& visibleClouds);
+    int viewportDepthRange(const pcl::PointCloud<PointInT>& pointCloud,
+                           const geometry_msgs::Pose& cameraPose, double& minDepth,
+                           double& maxDepth);
     void visualizeFOV(geometry_msgs::Pose location);
+    void visualizeFOV(OcclusionCullingContext<PointInT>& context) const;
     void visualizeRaycast(geometry_msgs::Pose location,
                           std::vector<geometry_msgs::Point> lineSegments,int color[]);
-    bool contains(pcl::PointCloud<PointInT> c, PointInT p);
-    pcl::PointCloud<PointInT> pointsDifference(pcl::PointCloud<PointInT> c2);
+    void visualizeRaycast(OcclusionCullingContext<PointInT>& context,
+                          const std::vector<geometry_msgs::Point>& lineSegments,
+                          int color[]) const;
+    bool contains(const pcl::PointCloud<PointInT>& c, const PointInT& p);
+    pcl::PointCloud<PointInT> pointsDifference(const pcl::PointCloud<PointInT>& c2);
+    void pointsDifference(const pcl::PointCloud<PointInT>& c2,
+                          pcl::PointCloud<PointInT>& difference);
 };
 #include "culling/occlusion_culling.hpp"
 #endif
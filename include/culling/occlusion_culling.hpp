@@ -29,6 +29,9 @@
 #define OCCLUSION_HPP_
 
 #include "culling/occlusion_culling.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 template <typename PointInT>
 void OcclusionCulling<PointInT>::initialize()
@@ -38,10 +41,8 @@ void OcclusionCulling<PointInT>::initialize()
 
     filteredCloud = typename pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     occlusionFreeCloud = typename pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    frustumCloud = typename pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     rayCloud = typename pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     cloudCopy = typename pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    occupancyGrid = typename pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     cloudCopy->points = cloud->points;
 
     nh.param<double>("voxel_res", voxelRes, 0.1);
@@ -49,52 +50,262 @@ void OcclusionCulling<PointInT>::initialize()
     nh.param<double>("sensor_ver_fov", sensorVerFOV, 45.0);
     nh.param<double>("sensor_near_limit", sensorNearLimit, 0.5);
     nh.param<double>("sensor_far_limit", sensorFarLimit, 8.0);
+    nh.param<int>("ray_interleave", rayInterleave, 1);
+    nh.param<std::string>("culling_backend", cullingBackend, "interleaved");
+    nh.param<std::string>("execution_mode", executionMode, "staged");
+    nh.param<bool>("sort_rays", sortRays, false);
+    nh.param<bool>("traverse_from_sensor", traverseFromSensor, true);
+    nh.param<bool>("visibility_field", useVisibilityField, false);
+    nh.param<bool>("view_entropy", useViewEntropy, false);
+    nh.param<bool>("real_time", realTime, false);
+    nh.param<int>("latency_window", latencyWindow, 10000);
+    nh.param<int>("batch_threads", batchThreads, 0);
+    nh.param<int>("visibility_field_directions", visibilityFieldDirections, 128);
+    nh.param<std::string>("visibility_field_file", visibilityFieldFile, "");
     nh.param<bool>("debug_enabled", debugEnabled, false);
     nh.param<std::string>("frame_id", frameId, "world");
 
     ROS_INFO("Voxel Res:%f, Debug Enabled:%d, sensor_near:%f, sensor_far:%f frame_id:%s",voxelRes, debugEnabled, sensorNearLimit, sensorFarLimit,frameId.c_str() );
     ROS_INFO("Sensor h,v,n,f=%f,%f,%f,%f",sensorHorFOV, sensorVerFOV, sensorNearLimit,
              sensorFarLimit);
+    ROS_INFO("Rays traversed in groups of:%d, sorted by direction:%d, from sensor:%d",
+             rayInterleave, sortRays, traverseFromSensor);
+    ROS_INFO("Real time:%d, latency percentiles over the last %d queries", realTime,
+             latencyWindow);
+#if PCL_VERSION_COMPARE(<, 1, 8, 0)
+    // the grid of every query is then built by pcl::VoxelGrid, whose buffers are not kept
+    if (realTime)
+        ROS_WARN("With PCL older than 1.8 the voxel grid of every query allocates, real-time "
+                 "queries are not free of allocations");
+#endif
+    ROS_INFO("Batch threads:%d (0 for all cores)", batchThreads);
+    // the distances of a voxel are indexed by a byte, a stored field never has more directions
+    if (visibilityFieldDirections < 1 || visibilityFieldDirections > 256)
+    {
+        ROS_WARN("Visibility field directions %d out of range, using %d",
+                 visibilityFieldDirections, std::max(1, std::min(visibilityFieldDirections, 256)));
+        visibilityFieldDirections = std::max(1, std::min(visibilityFieldDirections, 256));
+    }
+
+    // every backend gives the same states, they only differ in how the rays are scheduled
+    // an unknown name fails the construction: queries without rays would return empty visible
+    // surfaces, which a planner takes for fully occluded views
+    occlusionBackend = pcl::createOcclusionBackend<PointInT>(cullingBackend, rayInterleave);
+    if (!occlusionBackend)
+    {
+        ROS_FATAL("Culling backend %s is not available, use scalar, interleaved or threaded",
+                  cullingBackend.c_str());
+        throw std::invalid_argument("unknown culling_backend " + cullingBackend);
+    }
+    ROS_INFO("Culling backend:%s", occlusionBackend->getName().c_str());
+    if (sortRays && occlusionBackend->getName() != "interleaved")
+        ROS_WARN("Only the interleaved backend sorts the rays by direction, sort_rays has no "
+                 "effect on %s", cullingBackend.c_str());
+
+    // fused: one pass over the model culls the frustum and gathers the distinct target voxels,
+    // then one ray is traversed per voxel; the visible points are the same as staged
+    if (executionMode != "staged" && executionMode != "fused")
+    {
+        ROS_WARN("Execution mode %s is not available, using staged", executionMode.c_str());
+        executionMode = "staged";
+    }
+    if (executionMode == "fused" && (useViewEntropy || useVisibilityField))
+        ROS_WARN("Fused execution only covers the ray traversal, the %s runs staged",
+                 useViewEntropy ? "view entropy" : "visibility field");
+    ROS_INFO("Execution mode:%s", executionMode.c_str());
 
     originalVoxelsSize = 0.0;
-    id = 0.0;
+    AccuracyMaxSet = false;
 
     voxelFilterOriginal.setInputCloud(cloud);
     voxelFilterOriginal.setLeafSize(voxelRes, voxelRes, voxelRes);
+    voxelFilterOriginal.setDownsampleAllData(pcl::detail::HasColor<PointInT>::value);
     voxelFilterOriginal.initializeVoxelGrid();
     min_b1 = voxelFilterOriginal.getMinBoxCoordinates();
     max_b1 = voxelFilterOriginal.getMaxBoxCoordinates();
-    for (int kk = min_b1.z(); kk <= max_b1.z(); ++kk)
+
+    // the voxel grid holds one centroid per occupied voxel
+    *filteredCloud = voxelFilterOriginal.getFilteredPointCloud();
+    originalVoxelsSize = filteredCloud->points.size();
+
+    // the voxel of every model point, the same (i,j,k) as in the grid of any view since it
+    // only depends on the leaf size
+    int numPoints = static_cast<int>(cloud->points.size());
+    pointVoxels.resize(numPoints);
+    pointVoxelIds.resize(executionMode == "fused" ? numPoints : 0);
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < numPoints; i++)
+    {
+        const PointInT& point = cloud->points[i];
+        pointVoxels[i] = voxelFilterOriginal.getGridCoordinates(point.x, point.y, point.z);
+        if (!pointVoxelIds.empty())
+            pointVoxelIds[i] = voxelFilterOriginal.getCentroidIndexAt(pointVoxels[i]);
+    }
+    coveredVoxels.resize(filteredCloud->points.size());
+    coverage.resize(filteredCloud->points.size());
+
+    if (useVisibilityField)
+    {
+        // directional visibility of every model voxel, computed once and reused by every query
+        // a stored field is only reused for the same voxels of the model, not just the same
+        // settings: another model with the same leaf size would otherwise get its visibility
+        typename pcl::VisibilityFieldT<PointInT>::Voxels modelVoxels(filteredCloud->points.size());
+        for (size_t v = 0; v < filteredCloud->points.size(); ++v)
+        {
+            const PointInT& point = filteredCloud->points[v];
+            modelVoxels[v] = voxelFilterOriginal.getGridCoordinates(point.x, point.y, point.z);
+        }
+        visibilityField.setInputCloud(cloud);
+        if (visibilityFieldFile.empty() || visibilityField.load(visibilityFieldFile) == -1 ||
+            visibilityField.getLeafSize() != static_cast<float>(voxelRes) ||
+            visibilityField.getNumberOfDirections() != visibilityFieldDirections ||
+            visibilityField.getMaxRange() != static_cast<float>(sensorFarLimit) ||
+            visibilityField.size() != modelVoxels.size() ||
+            visibilityField.getVoxelHash() !=
+                pcl::VisibilityFieldT<PointInT>::hashVoxels(modelVoxels))
+        {
+            ros::Time tic = ros::Time::now();
+            visibilityField.setLeafSize(voxelRes);
+            visibilityField.setNumberOfDirections(visibilityFieldDirections);
+            visibilityField.setMaxRange(sensorFarLimit);
+            visibilityField.compute();
+            ros::Time toc = ros::Time::now();
+            ROS_INFO("Visibility field of %d voxels took:%f", (int)visibilityField.size(),
+                     toc.toSec() - tic.toSec());
+            if (!visibilityFieldFile.empty())
+                visibilityField.save(visibilityFieldFile);
+        }
+        ROS_INFO("Visibility field with %d directions, range:%f",
+                 visibilityField.getNumberOfDirections(), visibilityField.getMaxRange());
+    }
+
+    initializeContext(defaultContext);
+    frustumCloud = defaultContext.frustumCloud;
+    occupancyGrid = defaultContext.occupancyGrid;
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::initializeContext(OcclusionCullingContext<PointInT>& context) const
+{
+    context.fc.setInputCloud(cloud);
+    context.fc.setVerticalFOV(sensorVerFOV);
+    context.fc.setHorizontalFOV(sensorHorFOV);
+    context.fc.setNearPlaneDistance(sensorNearLimit);
+    context.fc.setFarPlaneDistance(sensorFarLimit);
+
+    // the occlusion estimation grid is rebuilt from the frustum cloud of every query
+    context.voxelFilter.setInputCloud(context.frustumCloud);
+    context.voxelFilter.setLeafSize(voxelRes, voxelRes, voxelRes);
+    // only the occupancy layout and xyz centroids of the per-view grid are used
+    context.voxelFilter.setDownsampleAllData(false);
+    context.voxelFilter.setSortRaysByDirection(sortRays);
+    context.voxelFilter.setTraverseFromSensor(traverseFromSensor);
+    context.latency.setWindowSize(std::max(latencyWindow, 0));
+    if (executionMode == "fused")
+        context.voxelTargets.assign(filteredCloud->points.size(), -1);
+
+    if (realTime)
+    {
+        // the frustum never holds more points than the model, nor its grid more cells than the
+        // model grid, so no query on the context allocates (with PCL 1.8 or newer, see
+        // initialize ())
+        size_t maxPoints = cloud->points.size();
+        Eigen::Vector3i divisions = max_b1 - min_b1 + Eigen::Vector3i::Ones();
+        size_t maxCells = static_cast<size_t>(divisions[0]) * divisions[1] * divisions[2];
+        context.fc.reserve(maxPoints);
+        context.frustumCloud->points.reserve(maxPoints);
+        context.voxelFilter.reserve(maxPoints, maxCells, rayInterleave);
+        context.frustumIndices.reserve(maxPoints);
+        context.targetVoxels.reserve(maxPoints);
+        context.targetStates.reserve(maxPoints);
+        context.visibleIndices.reserve(maxPoints);
+        context.visibleCloud.points.reserve(maxPoints);
+        if (executionMode == "fused")
+        {
+            context.pointTargets.reserve(maxPoints);
+            context.targetVoxelIds.reserve(maxPoints);
+        }
+        if (useViewEntropy)
+            context.pointEntropies.reserve(maxPoints);
+        ROS_INFO("Query context preallocated for %d points and %d cells", (int)maxPoints,
+                 (int)maxCells);
+    }
+}
+
+template <typename PointInT>
+bool OcclusionCulling<PointInT>::isFused() const
+{
+    // the visibility field and the view entropy read the frustum cloud
+    return executionMode == "fused" && !useViewEntropy &&
+           !(useVisibilityField && visibilityField.size() > 0);
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::frustumVoxelSweep(OcclusionCullingContext<PointInT>& context) const
+{
+    std::vector<int>& frustumIndices = context.frustumIndices;
+    std::vector<int>& pointTargets = context.pointTargets;
+    std::vector<int>& voxelTargets = context.voxelTargets;
+    std::vector<int>& targetVoxelIds = context.targetVoxelIds;
+    typename pcl::OcclusionBackend<PointInT>::VoxelVector& targetVoxels = context.targetVoxels;
+    frustumIndices.clear();
+    pointTargets.clear();
+    targetVoxelIds.clear();
+    targetVoxels.clear();
+
+    // the model is swept in blocks: the frustum test of a block is followed by the voxel
+    // lookups of its points while they are still in cache, and every voxel becomes a target once
+    const int blockSize = 256;
+    bool inside[blockSize];
+    context.fc.computePlanes();
+    int numPoints = static_cast<int>(cloud->points.size());
+    for (int begin = 0; begin < numPoints; begin += blockSize)
     {
-        for (int jj = min_b1.y(); jj <= max_b1.y(); ++jj)
+        int end = std::min(begin + blockSize, numPoints);
+        for (int i = begin; i < end; i++)
+            inside[i - begin] = context.fc.isInside(cloud->points[i]);
+        for (int i = begin; i < end; i++)
         {
-            for (int ii = min_b1.x(); ii <= max_b1.x(); ++ii)
+            if (!inside[i - begin])
+                continue;
+            int& target = voxelTargets[pointVoxelIds[i]];
+            if (target == -1)
             {
-                Eigen::Vector3i ijk1(ii, jj, kk);
-                int index1 = voxelFilterOriginal.getCentroidIndexAt(ijk1);
-                if (index1 != -1)
-                {
-                    originalVoxelsSize++;
-                }
+                target = static_cast<int>(targetVoxels.size());
+                targetVoxels.push_back(pointVoxels[i]);
+                targetVoxelIds.push_back(pointVoxelIds[i]);
             }
+            frustumIndices.push_back(i);
+            pointTargets.push_back(target);
         }
     }
 
-    pcl::VoxelGrid<PointInT> voxelgrid;
-    voxelgrid.setInputCloud(cloud);
-    voxelgrid.setLeafSize(voxelRes, voxelRes, voxelRes);
-    voxelgrid.filter(*filteredCloud);
+    // leave the voxel targets unset for the next query
+    for (size_t t = 0; t < targetVoxelIds.size(); t++)
+        voxelTargets[targetVoxelIds[t]] = -1;
+}
 
-    fc.setInputCloud(cloud);
-    fc.setVerticalFOV(sensorVerFOV);
-    fc.setHorizontalFOV(sensorHorFOV);
-    fc.setNearPlaneDistance(sensorNearLimit);
-    fc.setFarPlaneDistance(sensorFarLimit);
+template <typename PointInT>
+typename OcclusionCullingContext<PointInT>::Ptr OcclusionCulling<PointInT>::createContext() const
+{
+    typename OcclusionCullingContext<PointInT>::Ptr context(new OcclusionCullingContext<PointInT>);
+    initializeContext(*context);
+    return context;
 }
 
 template <typename PointInT>
 OcclusionCulling<PointInT>::OcclusionCulling(ros::NodeHandle &n, std::string modelName)
-    : nh(n), model(modelName), fc(true)
+    : nh(n)
+    , model(modelName)
+    , fc(defaultContext.fc)
+    , viewStatistics(defaultContext.viewStatistics)
+    , rayParallelism(defaultContext.rayParallelism)
+    , viewEntropy(defaultContext.viewEntropy)
+    , pointEntropies(defaultContext.pointEntropies)
+    , id(defaultContext.id)
+    , markerArray(defaultContext.markerArray)
+    , rayLines(defaultContext.rayLines)
+    , occupancyGridCloud(defaultContext.occupancyGridCloud)
 {
     cloud = typename pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     pcl::io::loadPCDFile<PointInT>(modelName, *cloud);
@@ -104,7 +315,16 @@ OcclusionCulling<PointInT>::OcclusionCulling(ros::NodeHandle &n, std::string mod
 template <typename PointInT>
 OcclusionCulling<PointInT>::OcclusionCulling(ros::NodeHandle &n,
                                              typename pcl::PointCloud<PointInT>::Ptr &cloudPtr)
-    : nh(n), fc(true)
+    : nh(n)
+    , fc(defaultContext.fc)
+    , viewStatistics(defaultContext.viewStatistics)
+    , rayParallelism(defaultContext.rayParallelism)
+    , viewEntropy(defaultContext.viewEntropy)
+    , pointEntropies(defaultContext.pointEntropies)
+    , id(defaultContext.id)
+    , markerArray(defaultContext.markerArray)
+    , rayLines(defaultContext.rayLines)
+    , occupancyGridCloud(defaultContext.occupancyGridCloud)
 {
     cloud = typename pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     cloud->points = cloudPtr->points;
@@ -121,7 +341,7 @@ visualization_msgs::MarkerArray OcclusionCulling<PointInT>::getFOV()
 {
     if(!debugEnabled)
         ROS_WARN("Debug is not enabled, FOV not drawn");
-    return markerArray;
+    return defaultContext.markerArray;
 }
 
 template <typename PointInT>
@@ -129,7 +349,7 @@ visualization_msgs::Marker OcclusionCulling<PointInT>::getRays()
 {
     if(!debugEnabled)
         ROS_WARN("Debug is not enabled, Rays not drawn");
-    return rayLines;
+    return defaultContext.rayLines;
 }
 
 template <typename PointInT>
@@ -137,143 +357,358 @@ sensor_msgs::PointCloud2 OcclusionCulling<PointInT>::getOccupancyGridCloud()
 {
     if(!debugEnabled)
         ROS_WARN("Debug is not enabled, OccupancyGrid not drawn");   
-    return occupancyGridCloud;
+    return defaultContext.occupancyGridCloud;
 }
 
 template <typename PointInT>
 pcl::PointCloud<PointInT> OcclusionCulling<PointInT>::getFrustumCloud()
 {
-    return *frustumCloud;
+    return *getFrustumCloudPtr();
+}
+
+template <typename PointInT>
+typename pcl::PointCloud<PointInT>::ConstPtr OcclusionCulling<PointInT>::getFrustumCloudPtr()
+{
+    // the fused execution only keeps the indices of the frustum points
+    if (isFused())
+        pcl::copyPointCloud(*cloud, defaultContext.frustumIndices, *frustumCloud);
+    return frustumCloud;
+}
+
+template <typename PointInT>
+float OcclusionCulling<PointInT>::getViewEntropy()
+{
+    return viewEntropy;
+}
+
+template <typename PointInT>
+std::string OcclusionCulling<PointInT>::getBackendName()
+{
+    return occlusionBackend->getName();
+}
+
+template <typename PointInT>
+pcl::PointCloud<pcl::PointXYZI> OcclusionCulling<PointInT>::visibilityHeatmap(int numDirections,
+                                                                              double padding)
+{
+    // number of model voxels visible from every free cell around the model, in one pass
+    pcl::VisibilityHeatmapT<PointInT> heatmap;
+    heatmap.setInputCloud(cloud);
+    heatmap.setLeafSize(voxelRes);
+    heatmap.setMaxRange(sensorFarLimit);
+    heatmap.setNumberOfDirections(numDirections);
+    heatmap.setPadding(padding);
+
+    ros::Time tic = ros::Time::now();
+    heatmap.compute();
+    ros::Time toc = ros::Time::now();
+
+    pcl::PointCloud<pcl::PointXYZI> cells;
+    heatmap.getHeatmap(cells);
+    cells.header.frame_id = frameId;
+    ROS_INFO("Visibility heatmap of %d cells took:%f", (int)cells.points.size(),
+             toc.toSec() - tic.toSec());
+    return cells;
 }
 
 template <typename PointInT>
 pcl::PointCloud<PointInT> OcclusionCulling<PointInT>::extractVisibleSurface(
     geometry_msgs::Pose location)
 {
-    ROS_INFO("ExtractVisibleSurface");
+    extractVisibleSurface(location, freeCloud);
+    return freeCloud;
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::extractVisibleSurface(const geometry_msgs::Pose& location,
+                                                       pcl::PointCloud<PointInT>& visibleCloud)
+{
+    extractVisibleSurface(location, defaultContext, visibleCloud);
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::extractVisibleSurface(const geometry_msgs::Pose& location,
+                                                       OcclusionCullingContext<PointInT>& context,
+                                                       pcl::PointCloud<PointInT>& visibleCloud) const
+{
+    size_t allocations = pcl::getAllocationCount();
+    ros::Time start = ros::Time::now();
+    cullVisibleSurface(location, context, visibleCloud);
+    context.latency.add(ros::Time::now().toSec() - start.toSec());
+    context.allocations = pcl::getAllocationCount() - allocations;
+}
+
+template <typename PointInT>
+pcl::VisibleSurfaceBatch OcclusionCulling<PointInT>::extractVisibleSurfaceBatch(
+    const std::vector<geometry_msgs::Pose>& locations)
+{
+    pcl::VisibleSurfaceBatch batch;
+    extractVisibleSurfaceBatch(locations, batch);
+    return batch;
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::extractVisibleSurfaceBatch(
+    const std::vector<geometry_msgs::Pose>& locations, pcl::VisibleSurfaceBatch& batch)
+{
+    int numThreads = batchThreads;
+    if (numThreads <= 0)
+    {
+        numThreads = 1;
+#ifdef _OPENMP
+        numThreads = omp_get_max_threads();
+#endif
+    }
+    // every thread queries the shared model with its own context, whose buffers are reused by
+    // the next batches
+    while (static_cast<int>(batchContexts.size()) < numThreads)
+        batchContexts.push_back(createContext());
+
+    int numViews = static_cast<int>(locations.size());
+    batch.visibleIndices.resize(numViews);
+    batch.frustumIndices.resize(numViews);
+    batch.viewStatistics.resize(numViews);
+    batch.latencies.resize(numViews);
+    batch.allocations.resize(numViews);
+    batch.rayParallelism.resize(numViews);
+    batch.threads = numThreads;
+
+    ros::Time start = ros::Time::now();
+#pragma omp parallel num_threads(numThreads)
+    {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        OcclusionCullingContext<PointInT>& context = *batchContexts[thread];
+        // the views are handed out one at a time, so a thread done with a cheap view takes the
+        // next one instead of waiting for a fixed share
+#pragma omp for schedule(dynamic, 1)
+        for (int v = 0; v < numViews; ++v)
+        {
+            size_t allocations = pcl::getThreadAllocationCount();
+            ros::Time tic = ros::Time::now();
+            extractVisibleSurface(locations[v], context, context.visibleCloud);
+            batch.latencies[v] = ros::Time::now().toSec() - tic.toSec();
+            // the other threads of the batch allocate meanwhile, so a view only counts the
+            // allocations of its own thread; its nested regions run serially on that thread
+            if (numThreads > 1)
+                context.allocations = pcl::getThreadAllocationCount() - allocations;
+            batch.visibleIndices[v] = context.visibleIndices;
+            batch.frustumIndices[v] = context.frustumIndices;
+            batch.viewStatistics[v] = context.viewStatistics;
+            batch.allocations[v] = context.allocations;
+            batch.rayParallelism[v] = context.rayParallelism;
+        }
+    }
+    batch.seconds = ros::Time::now().toSec() - start.toSec();
+    ROS_INFO("Batch of %d viewpoints on %d threads took:%f, viewpoints/s:%f", numViews,
+             numThreads, batch.seconds, batch.getViewpointsPerSecond());
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::cullVisibleSurface(const geometry_msgs::Pose& location,
+                                                    OcclusionCullingContext<PointInT>& context,
+                                                    pcl::PointCloud<PointInT>& visibleCloud) const
+{
+    ROS_DEBUG("ExtractVisibleSurface");
     tf::Quaternion q(location.orientation.x, location.orientation.y,
                            location.orientation.z,location.orientation.w);
     tf::Matrix3x3 m(q);
     double roll, pitch, yaw;
     m.getRPY(roll, pitch, yaw);
 
-    ROS_INFO("Location X:%f Y:%f Z:%f Yaw:%f", location.position.x, location.position.y,
-             location.position.z, yaw);
+    ROS_DEBUG("Location X:%f Y:%f Z:%f Yaw:%f", location.position.x, location.position.y,
+              location.position.z, yaw);
 
 
     //*****Frustum Culling*******
-    typename pcl::PointCloud<PointInT>::Ptr output(new pcl::PointCloud<PointInT>);
-    typename pcl::PointCloud<PointInT>::Ptr occlusionFreeCloud_local(new pcl::PointCloud<PointInT>);
+    // the frustum is filtered straight into the frustum cloud of the context, which is then the
+    // input of the occlusion estimation, so no cloud is copied on the way
+    const typename pcl::PointCloud<PointInT>::Ptr& output = context.frustumCloud;
+    visibleCloud.points.clear();
+    std::vector<int>& visibleIndices = context.visibleIndices;
+    visibleIndices.clear();
 
     Eigen::Matrix4f sensorPose = sensor2RobotTransform(location);
 
-    fc.setCameraPose(sensorPose);
+    // the indices of the frustum points in the model select their precomputed voxels
+    std::vector<int>& frustumIndices = context.frustumIndices;
+    bool fused = isFused();
+    context.fc.setCameraPose(sensorPose);
     ros::Time tic = ros::Time::now();
-    fc.filter(*output);
+    if (fused)
+    {
+        frustumVoxelSweep(context);
+        output->points.clear();
+        output->width = 0;
+        output->height = 1;
+    }
+    else
+    {
+        context.fc.filter(frustumIndices);
+        pcl::copyPointCloud(*cloud, frustumIndices, *output);
+    }
     ros::Time toc = ros::Time::now();
-    ROS_INFO("Frustum Filter took:%f", toc.toSec() - tic.toSec());
-    ROS_INFO("Input cloud size:%d Frustum size:%d", cloud->points.size(), output->size());
-
-    frustumCloud->header = output->header;
-    frustumCloud->sensor_origin_ = output->sensor_origin_;
-    frustumCloud->sensor_orientation_ = output->sensor_orientation_;
-    frustumCloud->points = output->points;
+    ROS_DEBUG("Frustum Filter took:%f", toc.toSec() - tic.toSec());
+    ROS_DEBUG("Input cloud size:%d Frustum size:%d", cloud->points.size(),
+              (int)frustumIndices.size());
 
     //****voxel grid occlusion estimation (occlusion culling) *****
-    output->sensor_origin_ =
-        Eigen::Vector4f(location.position.x, location.position.y, location.position.z, 0);
-    output->sensor_orientation_ =
-        Eigen::Quaternionf(location.orientation.w, location.orientation.x, location.orientation.y,
-                           location.orientation.z);
+    Eigen::Vector4f sensorOrigin(location.position.x, location.position.y, location.position.z, 0);
+
+    // the statistics of the view are updated with the depth of every visible point as it is
+    // found; the depth is the x coordinate of the viewport transform
+    const Eigen::Matrix<float, 3, 4> viewport = viewportTransform(location);
+    const float depthX = viewport(0, 0), depthY = viewport(0, 1), depthZ = viewport(0, 2);
+    const float depthOffset = viewport(0, 3);
+    pcl::ViewStatistics& viewStatistics = context.viewStatistics;
+    viewStatistics.reset(AccuracyMaxSet ? maxAccuracyError
+                                        : pcl::ViewStatistics::accuracyError(sensorFarLimit));
 
-    pcl::VoxelGridOcclusionEstimationT<PointInT> voxelFilter;
+    if (useVisibilityField && visibilityField.size() > 0)
+    {
+        // look up the direction to the sensor in the precomputed field instead of a ray traversal
+        tic = ros::Time::now();
+        for (uint i = 0; i < output->points.size(); i++)
+        {
+            int state;
+            Eigen::Vector4f p = output->points[i].getVector4fMap();
+            if (visibilityField.getVisibility(state, p, sensorOrigin) == 0 && state == 0)
+            {
+                visibleIndices.push_back(frustumIndices[i]);
+                visibleCloud.points.push_back(output->points[i]);
+                viewStatistics.add(depthX * p[0] + depthY * p[1] + depthZ * p[2] + depthOffset);
+            }
+        }
+        toc = ros::Time::now();
+        ROS_DEBUG("Visibility field lookup took:%f", toc.toSec() - tic.toSec());
+
+        visibleCloud.width = visibleCloud.points.size();
+        visibleCloud.height = 1;
+        ROS_DEBUG("Number of visible, non-occluded pointss:%d", visibleCloud.points.size());
+        if (debugEnabled)
+            visualizeFOV(context);
+        return;
+    }
+
+    pcl::VoxelGridOcclusionEstimationT<PointInT>& voxelFilter = context.voxelFilter;
     voxelFilter.setInputCloud(output);
-    voxelFilter.setLeafSize(voxelRes, voxelRes, voxelRes);
 
+    typename pcl::OcclusionBackend<PointInT>::VoxelVector& targetVoxels = context.targetVoxels;
     tic = ros::Time::now();
-    voxelFilter.initializeVoxelGrid();
+    // the fused sweep already found the occupied voxels of the view
+    if (!fused)
+        voxelFilter.initializeVoxelGrid();
+    else if (!targetVoxels.empty())
+        voxelFilter.initializeVoxelGrid(targetVoxels);
+    voxelFilter.setSensorOrigin(sensorOrigin);
     toc = ros::Time::now();
-    ROS_INFO("Voxel Filter took:%f", toc.toSec() - tic.toSec());
-    ROS_INFO("Number of points:%d", output->points.size());
+    ROS_DEBUG("Voxel Filter took:%f", toc.toSec() - tic.toSec());
+    ROS_DEBUG("Number of points:%d", (int)frustumIndices.size());
+
+    if (useViewEntropy)
+    {
+        // visibility and entropy of every frustum point as computed by the GPU implementation
+        tic = ros::Time::now();
+        voxelFilter.occlusionFreeEstimationAll(*output, visibleCloud, context.pointEntropies);
+        context.viewEntropy = voxelFilter.getEntropyTotal();
+        // the kernel measures the depth along z, so a sensor above or below all of the grid
+        // gives its points no entropy, as on the GPU
+        if (pcl_isnan(context.viewEntropy))
+            ROS_WARN("View entropy is not a number, the sensor is further along z than the "
+                     "depth error of the grid allows");
+        const std::vector<char>& freeStates = voxelFilter.getFreeStates();
+        for (size_t i = 0; i < freeStates.size(); i++)
+            if (freeStates[i])
+                visibleIndices.push_back(frustumIndices[i]);
+        toc = ros::Time::now();
+        ROS_DEBUG("Occlusion free estimation took:%f, view entropy:%f", toc.toSec() - tic.toSec(),
+                  context.viewEntropy);
+
+        for (uint i = 0; i < visibleCloud.points.size(); i++)
+        {
+            const PointInT& p = visibleCloud.points[i];
+            viewStatistics.add(depthX * p.x + depthY * p.y + depthZ * p.z + depthOffset);
+        }
+        ROS_DEBUG("Number of visible, non-occluded pointss:%d", visibleCloud.points.size());
+        if (debugEnabled)
+            visualizeFOV(context);
+        return;
+    }
     Eigen::Vector4f min,max;
 
     //pcl::getMinMax3D(*output,min,max); std::cout<<"Min:"<<min<<" Max:"<<max<<"\n";
 
-    int occupiedState, ret;
-    PointInT p1, p2;
     PointInT point;
-    std::vector<geometry_msgs::Point> lineSegments;
+    std::vector<geometry_msgs::Point>& lineSegments = context.lineSegments;
+    lineSegments.clear();
     geometry_msgs::Point linePoint;
-    occupancyGrid->points.clear();
-    std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > outRay;
+    context.occupancyGrid->points.clear();
 
     int redColor[3]  = {1,0,0};
     int cyanColor[3] = {0,1,1};
-    // iterate over the entire frustum points
-    int rayCounts = 0;
-    for (uint i = 0; i < output->points.size(); i++)
+
+    // the target voxel of every frustum point is gathered from the model, the grid of the view
+    // is built from the frustum points so each of them lies in one of its voxels; then the
+    // rays are traversed in groups. The fused sweep gathered one target per voxel instead, the
+    // state of a ray only depending on its voxel
+    std::vector<int>& targetStates = context.targetStates;
+    const std::vector<int>& pointTargets = context.pointTargets;
+    int numPoints = static_cast<int>(frustumIndices.size());
+    if (!fused)
     {
-        PointInT ptest = output->points[i];
-        Eigen::Vector3i ijk = voxelFilter.getGridCoordinates(ptest.x, ptest.y, ptest.z);
+        targetVoxels.resize(numPoints);
+        for (int i = 0; i < numPoints; i++)
+            targetVoxels[i] = pointVoxels[frustumIndices[i]];
+    }
 
-        // Voxel is out of bounds?
-        if (voxelFilter.getCentroidIndexAt(ijk) == -1)
-        {
-            continue;
-        }
-        Eigen::Vector4f centroid = voxelFilter.getCentroidCoordinate(ijk);
-        point = PointInT(0, 244, 0);
-        point.x = centroid[0];
-        point.y = centroid[1];
-        point.z = centroid[2];
-
-        outRay.clear();
-        //ret = voxelFilter.occlusionEstimation(occupiedState, outRay, ijk);
-        ret = voxelFilter.occlusionEstimation(occupiedState, ijk);
-        if (ret == -1 || occupiedState == 1)
+    tic = ros::Time::now();
+    context.rayParallelism = 0.0;
+    if (!targetVoxels.empty())
+    {
+        occlusionBackend->estimate(voxelFilter, targetStates, targetVoxels);
+        context.rayParallelism = occlusionBackend->getRayParallelism(voxelFilter,
+                                                                     targetVoxels.size());
+    }
+    toc = ros::Time::now();
+    ROS_DEBUG("Ray traversal of %d targets took:%f, rays in flight:%f", (int)targetVoxels.size(),
+              toc.toSec() - tic.toSec(), context.rayParallelism);
+
+    // iterate over the entire frustum points
+    for (int i = 0; i < numPoints; i++)
+    {
+        int t = fused ? pointTargets[i] : i;
+        if (targetStates[t] != 0)
            continue;
-        //ROS_INFO("Ray Size:%d",outRay.size());
-        // estimate the occluded space
-        //std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > occluded_voxels;
-        //vg.occlusionEstimationAll (occluded_voxels);
-        /*
-        typename pcl::PointCloud<PointInT>::Ptr occ_centroids(new pcl::PointCloud<PointInT>);
-        occ_centroids->width = static_cast<int> (outRay.size ());
-        occ_centroids->height = 1;
-        occ_centroids->is_dense = false;
-        occ_centroids->points.resize (outRay.size ());
-        */
-       /*
-        for (size_t i = 0; i < outRay.size (); ++i)
-        {
-            Eigen::Vector4f xyz = voxelFilter.getCentroidCoordinate (outRay[i]);
-            point = PointInT(0, 244, 0);
-            point.x = xyz[0];
-            point.y = xyz[1];
-            point.z = xyz[2];
-            //occ_centroids->points[i] = point;
-            occupancyGrid->points.push_back(point);
-            ROS_INFO("Ray Point %d, X:%f Y:%f Z:%f",i,point.x,point.y,point.z);
-        }
-        */
-        occlusionFreeCloud_local->points.push_back(ptest);
+        const PointInT& ptest = cloud->points[frustumIndices[i]];
+        visibleIndices.push_back(frustumIndices[i]);
+        visibleCloud.points.push_back(ptest);
+        viewStatistics.add(depthX * ptest.x + depthY * ptest.y + depthZ * ptest.z + depthOffset);
         if (debugEnabled)
         {
+            Eigen::Vector4f centroid = voxelFilter.getCentroidCoordinate(targetVoxels[t]);
+            point = PointInT();
+            pcl::detail::DebugColor<PointInT>::set(point, 0, 244, 0);
+            point.x = centroid[0];
+            point.y = centroid[1];
+            point.z = centroid[2];
+
             // estimate direction to target voxel
-            Eigen::Vector4f direction = centroid - output->sensor_origin_;
+            Eigen::Vector4f direction = centroid - sensorOrigin;
             direction.normalize();
 
             //estimate entry point into the voxel grid
-            float tmin = voxelFilter.rayBoxIntersection(output->sensor_origin_, direction, p1, p2);
+            float tmin = voxelFilter.getRayStart(sensorOrigin, direction);
             if (tmin == -1)
                 continue;
 
             // coordinate of the boundary of the voxel grid
-            Eigen::Vector4f start = output->sensor_origin_ + tmin * direction;
+            Eigen::Vector4f start = sensorOrigin + tmin * direction;
             /*
-            linePoint.x = output->sensor_origin_[0];
-            linePoint.y = output->sensor_origin_[1];
-            linePoint.z = output->sensor_origin_[2];
+            linePoint.x = sensorOrigin[0];
+            linePoint.y = sensorOrigin[1];
+            linePoint.z = sensorOrigin[2];
             lineSegments.push_back(linePoint);
 
             linePoint.x = start[0];
@@ -292,37 +727,422 @@ pcl::PointCloud<PointInT> OcclusionCulling<PointInT>::extractVisibleSurface(
             linePoint.z = centroid[2];
             lineSegments.push_back(linePoint);
             
-            occupancyGrid->points.push_back(point);
+            context.occupancyGrid->points.push_back(point);
             //ROS_INFO("Start xyz(%f,%f,%f) End xyz(%f,%f,%f)",start[0],start[1],start[2],centroid[0],centroid[1],centroid[2]);
         }
     }
 
-    freeCloud.points = occlusionFreeCloud_local->points;
-    ROS_INFO("Number of visible, non-occluded pointss:%d", freeCloud.points.size());
-    visualizeFOV(location);
+    visibleCloud.width = visibleCloud.points.size();
+    visibleCloud.height = 1;
+    ROS_DEBUG("Number of visible, non-occluded pointss:%d", visibleCloud.points.size());
+    // the markers are only drawn for debugging, they allocate on every query
     if (debugEnabled)
-        visualizeRaycast(location, lineSegments, redColor);
-    return freeCloud;
+    {
+        visualizeFOV(context);
+        visualizeRaycast(context, lineSegments, redColor);
+    }
+}
+
+template <typename PointInT>
+int OcclusionCulling<PointInT>::getModelVoxelId(const PointInT& point)
+{
+    // the leaf layout is only looked up inside the model grid as it would alias outside
+    Eigen::Vector3i ijk = voxelFilterOriginal.getGridCoordinates(point.x, point.y, point.z);
+    if ((ijk.array() < min_b1.array()).any() || (ijk.array() > max_b1.array()).any())
+        return -1;
+    return voxelFilterOriginal.getCentroidIndexAt(ijk);
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::markVoxels(const pcl::PointCloud<PointInT>& pointCloud,
+                                            pcl::VoxelSet& voxels)
+{
+    if (voxels.capacity() != filteredCloud->points.size())
+        voxels.resize(filteredCloud->points.size());
+    for (size_t i = 0; i < pointCloud.points.size(); i++)
+    {
+        int voxelId = getModelVoxelId(pointCloud.points[i]);
+        if (voxelId != -1)
+            voxels.insert(voxelId);
+    }
+}
+
+template <typename PointInT>
+float OcclusionCulling<PointInT>::calcCoveragePercent(const pcl::VoxelSet& voxels)
+{
+    if (originalVoxelsSize == 0)
+        return 0;
+    return 100.0f * static_cast<float>(voxels.count()) / originalVoxelsSize;
+}
+
+template <typename PointInT>
+float OcclusionCulling<PointInT>::calcCoveragePercent(
+    typename pcl::PointCloud<PointInT>::Ptr cloud_filtered)
+{
+    // mark the model voxels containing a point of the cloud, the covered voxels are counted
+    coveredVoxels.clear();
+    markVoxels(*cloud_filtered, coveredVoxels);
+    return calcCoveragePercent(coveredVoxels);
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::getModelVoxelIds(const pcl::PointCloud<PointInT>& pointCloud,
+                                                  std::vector<int>& voxelIds)
+{
+    voxelIds.resize(pointCloud.points.size());
+    for (size_t i = 0; i < pointCloud.points.size(); i++)
+        voxelIds[i] = getModelVoxelId(pointCloud.points[i]);
+}
+
+template <typename PointInT>
+int OcclusionCulling<PointInT>::addViewCoverage(const pcl::PointCloud<PointInT>& visibleCloud,
+                                                std::vector<int>& newlyCovered)
+{
+    // only the voxels of this view are touched, the coverage of the previous views is kept
+    std::vector<int> voxelIds;
+    getModelVoxelIds(visibleCloud, voxelIds);
+    int viewId = coverage.addView(voxelIds, newlyCovered);
+    ROS_DEBUG("View %d covered %d new voxels, coverage:%f", viewId, (int)newlyCovered.size(),
+              coverage.getCoveragePercent());
+    return viewId;
+}
+
+template <typename PointInT>
+float OcclusionCulling<PointInT>::removeViewCoverage(int viewId)
+{
+    std::vector<int> uncovered;
+    if (coverage.removeView(viewId, uncovered) == -1)
+        ROS_WARN("View %d is not part of the coverage", viewId);
+    return coverage.getCoveragePercent();
+}
+
+template <typename PointInT>
+bool OcclusionCulling<PointInT>::contains(const pcl::PointCloud<PointInT>& c, const PointInT& p)
+{
+    typename pcl::PointCloud<PointInT>::const_iterator it = c.begin();
+    for (; it != c.end(); ++it)
+    {
+        if (it->x == p.x && it->y == p.y && it->z == p.z)
+            return true;
+    }
+    return false;
+}
+
+//c2 the cloud that you want to compare with the original cloud in the occlusion culling
+template <typename PointInT>
+pcl::PointCloud<PointInT> OcclusionCulling<PointInT>::pointsDifference(
+    const pcl::PointCloud<PointInT>& c2)
+{
+    pcl::PointCloud<PointInT> inter;
+    pointsDifference(c2, inter);
+    return inter;
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::pointsDifference(const pcl::PointCloud<PointInT>& c2,
+                                                  pcl::PointCloud<PointInT>& difference)
+{
+    // the points of c2 are hashed once instead of scanning c2 for every model point
+    pcl::pointsDifference(*cloud, c2, difference);
+}
+
+template <typename PointInT>
+double OcclusionCulling<PointInT>::calcAvgAccuracy(const pcl::PointCloud<PointInT>& pointCloud)
+{
+    pcl::ViewStatistics stats;
+    for (int j = 0; j < pointCloud.size(); j++)
+        stats.add(pointCloud.points[j].z);  //depth
+    return stats.getAvgAccuracyError();
+}
+
+template <typename PointInT>
+double OcclusionCulling<PointInT>::calcAvgAccuracy(const pcl::PointCloud<PointInT>& pointCloud,
+                                                   const geometry_msgs::Pose& cameraPose)
+{
+    std::vector<float> depth;
+    pointCloudViewportDepth(pointCloud, cameraPose, depth);
+
+    pcl::ViewStatistics stats;
+    for (int j = 0; j < depth.size(); j++)
+        stats.add(depth[j]);
+    return stats.getAvgAccuracyError();
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::SSMaxMinAccuracy(
+    const std::vector<geometry_msgs::PoseArray>& sensorsPoses)
+{
+    std::vector<typename pcl::PointCloud<PointInT>::ConstPtr> visibleClouds;
+    SSMaxMinAccuracy(sensorsPoses, visibleClouds);
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::SSMaxMinAccuracy(
+    const std::vector<geometry_msgs::PoseArray>& sensorsPoses,
+    const std::vector<typename pcl::PointCloud<PointInT>::ConstPtr>& visibleClouds)
+{
+    // the poses without a visible surface from the caller are extracted in one batch, whose
+    // view statistics hold the depth extrema of every view; the clouds of the caller only have
+    // their points, so their depth range is computed here
+    std::vector<geometry_msgs::Pose> extractPoses;
+    std::vector<const geometry_msgs::Pose*> givenPoses;
+    std::vector<typename pcl::PointCloud<PointInT>::ConstPtr> givenClouds;
+    size_t v = 0;
+    for (int i = 0; i < sensorsPoses.size(); i++)
+    {
+        for (int j = 0; j < sensorsPoses[i].poses.size(); j++, v++)
+        {
+            if (v < visibleClouds.size() && visibleClouds[v])
+            {
+                givenPoses.push_back(&sensorsPoses[i].poses[j]);
+                givenClouds.push_back(visibleClouds[v]);
+            }
+            else
+                extractPoses.push_back(sensorsPoses[i].poses[j]);
+        }
+    }
+
+    double max = 0, min = std::numeric_limits<double>::max();
+    if (!extractPoses.empty())
+    {
+        pcl::VisibleSurfaceBatch batch;
+        extractVisibleSurfaceBatch(extractPoses, batch);
+        for (size_t b = 0; b < batch.size(); b++)
+        {
+            const pcl::ViewStatistics& stats = batch.viewStatistics[b];
+            if (stats.getCount() == 0)
+                continue;
+            if (max < stats.getMaxDepth())
+                max = stats.getMaxDepth();
+            if (min > stats.getMinDepth())
+                min = stats.getMinDepth();
+        }
+    }
+
+    int numGiven = static_cast<int>(givenPoses.size());
+#pragma omp parallel for schedule(dynamic) reduction(max : max) reduction(min : min)
+    for (int g = 0; g < numGiven; g++)
+    {
+        double poseMin, poseMax;
+        if (viewportDepthRange(*givenClouds[g], *givenPoses[g], poseMin, poseMax) == 0)
+        {
+            if (max < poseMax)
+                max = poseMax;
+            if (min > poseMin)
+                min = poseMin;
+        }
+    }
+
+    // the standard deviation equation is taken from paper
+    maxAccuracyError = pcl::ViewStatistics::accuracyError(max);
+    minAccuracyError = pcl::ViewStatistics::accuracyError(min);
+    std::cout << "Maximum error: " << maxAccuracyError << " for the depth of: " << max << "\n";
+    std::cout << "Minimum error: " << minAccuracyError << " for the depth of: " << min << "\n";
+
+    AccuracyMaxSet = true;
+}
+
+template <typename PointInT>
+int OcclusionCulling<PointInT>::viewportDepthRange(const pcl::PointCloud<PointInT>& pointCloud,
+                                                   const geometry_msgs::Pose& cameraPose,
+                                                   double& minDepth, double& maxDepth)
+{
+    if (pointCloud.points.empty())
+        return -1;
+
+    // the depth is the x coordinate of pointCloudViewportTransform
+    const Eigen::Matrix<float, 3, 4> transform = viewportTransform(cameraPose);
+    const float rowX = transform(0, 0), rowY = transform(0, 1), rowZ = transform(0, 2);
+    const float offset = transform(0, 3);
+
+    minDepth = std::numeric_limits<double>::max();
+    maxDepth = -std::numeric_limits<double>::max();
+    for (size_t k = 0; k < pointCloud.points.size(); k++)
+    {
+        const PointInT& point = pointCloud.points[k];
+        float depth = rowX * point.x + rowY * point.y + rowZ * point.z + offset;
+        if (maxDepth < depth)
+            maxDepth = depth;
+        if (minDepth > depth)
+            minDepth = depth;
+    }
+    return 0;
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::transformPointMatVec(const tf::Vector3& translation,
+                                                      const tf::Matrix3x3& rotation,
+                                                      const geometry_msgs::Point32& in,
+                                                      geometry_msgs::Point32& out)
+{
+    double x =
+        rotation[0].x() * in.x + rotation[0].y() * in.y + rotation[0].z() * in.z + translation.x();
+    double y =
+        rotation[1].x() * in.x + rotation[1].y() * in.y + rotation[1].z() * in.z + translation.y();
+    double z =
+        rotation[2].x() * in.x + rotation[2].y() * in.y + rotation[2].z() * in.z + translation.z();
+
+    out.x = x;
+    out.y = y;
+    out.z = z;
+}
+
+template <typename PointInT>
+pcl::PointCloud<PointInT> OcclusionCulling<PointInT>::pointCloudViewportTransform(
+    const pcl::PointCloud<PointInT>& pointCloud, const geometry_msgs::Pose& cameraPose)
+{
+    pcl::PointCloud<PointInT> posArray;
+    pointCloudViewportTransform(pointCloud, cameraPose, posArray);
+    return posArray;
+}
+
+template <typename PointInT>
+Eigen::Matrix<float, 3, 4> OcclusionCulling<PointInT>::viewportTransform(
+    const geometry_msgs::Pose& cameraPose) const
+{
+    // rotation of the uav interms of the previous viewport of the pointcloud
+    tf::Quaternion qt(cameraPose.orientation.x, cameraPose.orientation.y, cameraPose.orientation.z,
+                      cameraPose.orientation.w);
+    double r, p, y;
+    tf::Matrix3x3(qt).getRPY(r, p, y);
+
+    // rotation around z (yaw) according to the camera orientation
+    double yaw = -1 * y;
+    Eigen::Matrix3d rotZ;
+    rotZ << std::cos(yaw), -1 * std::sin(yaw), 0, std::sin(yaw), std::cos(yaw), 0, 0, 0, 1;
+
+    // rotation around y (pitch) according to the camera tilt
+    double pitch = -1 * p;
+    Eigen::Matrix3d rotY;
+    rotY << std::cos(pitch), 0, std::sin(pitch), 0, 1, 0, -1 * std::sin(pitch), 0, std::cos(pitch);
+
+    // translation to the camera position followed by both rotations
+    Eigen::Vector3d cameraPosition(cameraPose.position.x, cameraPose.position.y,
+                                   cameraPose.position.z);
+    Eigen::Matrix<double, 3, 4> transform;
+    transform.leftCols<3>() = rotY * rotZ;
+    transform.col(3) = -(transform.leftCols<3>() * cameraPosition);
+    return transform.cast<float>();
+}
+
+//translate the pcd viewport (0,0,0) to the camera viewport (viewpoints)
+//All pcd files have viewports set to (0,0,0) ... occlusion culling extract the point cloud but doesn't change the point cloud depth
+//This function will transform the viewport to the new viewport
+template <typename PointInT>
+void OcclusionCulling<PointInT>::pointCloudViewportTransform(
+    const pcl::PointCloud<PointInT>& pointCloud, const geometry_msgs::Pose& cameraPose,
+    pcl::PointCloud<PointInT>& transformedCloud)
+{
+    const Eigen::Matrix<float, 3, 4> m = viewportTransform(cameraPose);
+    const float m00 = m(0, 0), m01 = m(0, 1), m02 = m(0, 2), m03 = m(0, 3);
+    const float m10 = m(1, 0), m11 = m(1, 1), m12 = m(1, 2), m13 = m(1, 3);
+    const float m20 = m(2, 0), m21 = m(2, 1), m22 = m(2, 2), m23 = m(2, 3);
+
+    // every block of points is gathered into coordinate arrays, transformed with one
+    // vectorized loop and written back, so the output may also be the input cloud
+    const int blockSize = 64;
+    int numPoints = static_cast<int>(pointCloud.points.size());
+    transformedCloud.points.resize(numPoints);
+#pragma omp parallel for schedule(static)
+    for (int begin = 0; begin < numPoints; begin += blockSize)
+    {
+        int n = std::min(blockSize, numPoints - begin);
+        float x[blockSize], y[blockSize], z[blockSize];
+        float outX[blockSize], outY[blockSize], outZ[blockSize];
+        for (int b = 0; b < n; b++)
+        {
+            const PointInT& point = pointCloud.points[begin + b];
+            x[b] = point.x;
+            y[b] = point.y;
+            z[b] = point.z;
+        }
+#pragma omp simd
+        for (int b = 0; b < n; b++)
+        {
+            outX[b] = m00 * x[b] + m01 * y[b] + m02 * z[b] + m03;
+            outY[b] = m10 * x[b] + m11 * y[b] + m12 * z[b] + m13;
+            outZ[b] = m20 * x[b] + m21 * y[b] + m22 * z[b] + m23;
+        }
+        for (int b = 0; b < n; b++)
+        {
+            PointInT finalPt;
+            finalPt.x = outX[b];
+            finalPt.y = outY[b];
+            finalPt.z = outZ[b];
+            transformedCloud.points[begin + b] = finalPt;
+        }
+    }
+
+    if (&transformedCloud != &pointCloud)
+        transformedCloud.header = pointCloud.header;
+    transformedCloud.width = transformedCloud.points.size();
+    transformedCloud.height = 1;
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::pointCloudViewportDepth(
+    const pcl::PointCloud<PointInT>& pointCloud, const geometry_msgs::Pose& cameraPose,
+    std::vector<float>& depth)
+{
+    // only the x coordinate of the viewport transform, the depth of the frustum camera
+    const Eigen::Matrix<float, 3, 4> m = viewportTransform(cameraPose);
+    const float m00 = m(0, 0), m01 = m(0, 1), m02 = m(0, 2), m03 = m(0, 3);
+
+    const int blockSize = 64;
+    int numPoints = static_cast<int>(pointCloud.points.size());
+    depth.resize(numPoints);
+#pragma omp parallel for schedule(static)
+    for (int begin = 0; begin < numPoints; begin += blockSize)
+    {
+        int n = std::min(blockSize, numPoints - begin);
+        float x[blockSize], y[blockSize], z[blockSize];
+        for (int b = 0; b < n; b++)
+        {
+            const PointInT& point = pointCloud.points[begin + b];
+            x[b] = point.x;
+            y[b] = point.y;
+            z[b] = point.z;
+        }
+        float* out = &depth[begin];
+#pragma omp simd
+        for (int b = 0; b < n; b++)
+            out[b] = m00 * x[b] + m01 * y[b] + m02 * z[b] + m03;
+    }
 }
 
 template <typename PointInT>
 void OcclusionCulling<PointInT>::visualizeRaycast(geometry_msgs::Pose location,
                                                   std::vector<geometry_msgs::Point> lineSegments, int color[])
 {
+    visualizeRaycast(defaultContext, lineSegments, color);
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::visualizeRaycast(
+    OcclusionCullingContext<PointInT>& context,
+    const std::vector<geometry_msgs::Point>& lineSegments, int color[]) const
+{
 
-    rayLines = drawLines(lineSegments, 0, color, frameId, 0.02);
-    pcl::toROSMsg(*occupancyGrid, occupancyGridCloud);
-    occupancyGridCloud.header.frame_id = frameId;
-    occupancyGridCloud.header.stamp = ros::Time::now();
+    context.rayLines = drawLines(lineSegments, 0, color, frameId, 0.02);
+    pcl::toROSMsg(*context.occupancyGrid, context.occupancyGridCloud);
+    context.occupancyGridCloud.header.frame_id = frameId;
+    context.occupancyGridCloud.header.stamp = ros::Time::now();
 }
 
 template <typename PointInT>
 void OcclusionCulling<PointInT>::visualizeFOV(geometry_msgs::Pose location)
+{
+    visualizeFOV(defaultContext);
+}
+
+template <typename PointInT>
+void OcclusionCulling<PointInT>::visualizeFOV(OcclusionCullingContext<PointInT>& context) const
 {
     //*** visualization the FOV *****
+    const pcl::FrustumCullingTT<PointInT>& fc = context.fc;
     std::vector<geometry_msgs::Point> fov_points;
     visualization_msgs::Marker linesList1, linesList2, linesList3, linesList4;
-    markerArray.markers.clear();
+    context.markerArray.markers.clear();
     int c_color[3];
     geometry_msgs::Point point1;
     point1.x = fc.fp_bl[0];
@@ -370,7 +1190,7 @@ void OcclusionCulling<PointInT>::visualizeFOV(geometry_msgs::Pose location)
     c_color[0] = 1;
     c_color[1] = 0;
     c_color[2] = 1;
-    linesList1 = drawLines(fov_linesNear, id++, c_color);  //purple
+    linesList1 = drawLines(fov_linesNear, context.id++, c_color);  //purple
 
     std::vector<geometry_msgs::Point> fov_linesFar;
     fov_linesFar.push_back(fov_points[0]);
@@ -384,7 +1204,7 @@ void OcclusionCulling<PointInT>::visualizeFOV(geometry_msgs::Pose location)
     c_color[0] = 1;
     c_color[1] = 1;
     c_color[2] = 0;
-    linesList2 = drawLines(fov_linesFar, id++, c_color);  //yellow
+    linesList2 = drawLines(fov_linesFar, context.id++, c_color);  //yellow
 
     std::vector<geometry_msgs::Point> fov_linestop;
     fov_linestop.push_back(fov_points[7]);
@@ -394,7 +1214,7 @@ void OcclusionCulling<PointInT>::visualizeFOV(geometry_msgs::Pose location)
     c_color[0] = 0;
     c_color[1] = 1;
     c_color[2] = 0;
-    linesList3 = drawLines(fov_linestop, id++, c_color);  //green
+    linesList3 = drawLines(fov_linestop, context.id++, c_color);  //green
 
     std::vector<geometry_msgs::Point> fov_linesbottom;
     fov_linesbottom.push_back(fov_points[5]);
@@ -404,12 +1224,12 @@ void OcclusionCulling<PointInT>::visualizeFOV(geometry_msgs::Pose location)
     c_color[0] = 0;
     c_color[1] = 0;
     c_color[2] = 1;
-    linesList4 = drawLines(fov_linesbottom, id++, c_color);  //blue
+    linesList4 = drawLines(fov_linesbottom, context.id++, c_color);  //blue
 
-    markerArray.markers.push_back(linesList1);
-    markerArray.markers.push_back(linesList2);
-    markerArray.markers.push_back(linesList3);
-    markerArray.markers.push_back(linesList4);
+    context.markerArray.markers.push_back(linesList1);
+    context.markerArray.markers.push_back(linesList2);
+    context.markerArray.markers.push_back(linesList3);
+    context.markerArray.markers.push_back(linesList4);
 }
 
 #endif
@@ -0,0 +1,111 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef OCCLUSION_CONTEXT_H_
+#define OCCLUSION_CONTEXT_H_
+
+#include <sensor_msgs/PointCloud2.h>
+#include <geometry_msgs/Point.h>
+#include <visualization_msgs/Marker.h>
+#include <visualization_msgs/MarkerArray.h>
+#include <boost/shared_ptr.hpp>
+
+#include <culling/frustum_culling.h>
+#include <culling/latency_statistics.h>
+#include <culling/occlusion_backend.h>
+#include <culling/view_statistics.h>
+#include <culling/voxel_grid_occlusion_estimation.h>
+#include <pcl/point_cloud.h>
+#include <vector>
+
+/** \brief The scratch buffers and results of one visible surface query. An OcclusionCulling
+  * model is only read by OcclusionCulling::extractVisibleSurface (location, context, visible),
+  * so any number of threads can query the same model, each with its own context.
+  *
+  * \code
+  * OcclusionCullingContext<PointInT>::Ptr context = occlusionCulling.createContext();
+  * occlusionCulling.extractVisibleSurface(pose, *context, visibleCloud);
+  * \endcode
+  */
+template <typename PointInT>
+class OcclusionCullingContext
+{
+  public:
+    typedef boost::shared_ptr<OcclusionCullingContext<PointInT> > Ptr;
+
+    // frustum of the query, its input is the model cloud
+    pcl::FrustumCullingTT<PointInT> fc;
+    std::vector<int> frustumIndices;
+    typename pcl::PointCloud<PointInT>::Ptr frustumCloud;
+
+    // scratch buffers of the occlusion estimation, kept across queries so that they only grow
+    // to the largest frustum queried: a query allocates only when one of them outgrows its
+    // capacity (never once initializeContext reserved them in real-time mode), which the
+    // malloc-level count of culling/allocation_counter.h confirms
+    pcl::VoxelGridOcclusionEstimationT<PointInT> voxelFilter;
+    typename pcl::OcclusionBackend<PointInT>::VoxelVector targetVoxels;
+    std::vector<int> targetStates;
+    std::vector<geometry_msgs::Point> lineSegments;
+
+    // fused execution: the target of every frustum point, the target of every model voxel (-1
+    // between queries) and the model voxels that got a target during the query
+    std::vector<int> pointTargets;
+    std::vector<int> voxelTargets;
+    std::vector<int> targetVoxelIds;
+
+    // results of the last query: the model indices of its visible points, its heap allocations
+    // (counted by programs that install the hooks of culling/allocation_counter.h) and the
+    // latency of the queries so far
+    std::vector<int> visibleIndices;
+    pcl::ViewStatistics viewStatistics;
+    size_t allocations;
+    pcl::LatencyStatistics latency;
+    double rayParallelism;
+    float viewEntropy;
+    std::vector<float> pointEntropies;
+
+    // visible cloud of the batch queries run on the context
+    pcl::PointCloud<PointInT> visibleCloud;
+
+    // debug visualization of the last query
+    double id;
+    typename pcl::PointCloud<PointInT>::Ptr occupancyGrid;
+    visualization_msgs::MarkerArray markerArray;
+    visualization_msgs::Marker rayLines;
+    sensor_msgs::PointCloud2 occupancyGridCloud;
+
+    OcclusionCullingContext()
+        : frustumCloud(new pcl::PointCloud<PointInT>)
+        , allocations(0)
+        , rayParallelism(0.0)
+        , viewEntropy(0.0)
+        , id(0.0)
+        , occupancyGrid(new pcl::PointCloud<PointInT>)
+    {
+    }
+
+  private:
+    // the filters keep pointers to their indices, copies would share them
+    OcclusionCullingContext(const OcclusionCullingContext&);
+    OcclusionCullingContext& operator=(const OcclusionCullingContext&);
+};
+
+#endif
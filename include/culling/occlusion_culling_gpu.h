@@ -35,7 +35,9 @@
 #include "ros/ros.h"
 
 //PCL
+#include <culling/culling_engine.h>
 #include <culling/frustum_culling_gpu.h>
+#include <culling/point_set_operations.h>
 #include <culling/voxel_grid_occlusion_estimation_gpu.h>
 #include <geometry_msgs/Point32.h>
 #include <geometry_msgs/PoseArray.h>
@@ -47,10 +49,13 @@
 #include <pcl_conversions/pcl_conversions.h>
 #include <iostream>
 
-template <typename PointInT>
-class OcclusionCullingGPU
+// the accelerator backend of createCullingEngine ()
+class OcclusionCullingGPU : public CullingEngine<pcl::PointXYZ>
 {
   public:
+    // the GPU filters work on pcl::PointXYZ
+    typedef pcl::PointXYZ PointInT;
+
     //attributes
     ros::NodeHandle nh;
     std::string model;
@@ -66,6 +71,7 @@ class OcclusionCullingGPU
 
     pcl::PointCloud<PointInT> freeCloud;
     float voxelRes, OriginalVoxelsSize, viewEntropy;
+    double sensorHorFOV, sensorVerFOV, sensorNearLimit, sensorFarLimit;
     double id;
     pcl::VoxelGridOcclusionEstimationGPU voxelFilterOriginal;
     Eigen::Vector3i max_b1, min_b1;
@@ -82,16 +88,22 @@ class OcclusionCullingGPU
     OcclusionCullingGPU(std::string modelName);
     OcclusionCullingGPU();
     ~OcclusionCullingGPU();
+    void initialize();
     pcl::PointCloud<PointInT> extractVisibleSurface(geometry_msgs::Pose location);
+    virtual void extractVisibleSurface(const geometry_msgs::Pose& location,
+                                       pcl::PointCloud<PointInT>& visibleCloud);
     //    float calcCoveragePercent(geometry_msgs::Pose location);
-    float calcCoveragePercent(pcl::PointCloud<PointInT>::Ptr cloud_filtered);
+    virtual float calcCoveragePercent(pcl::PointCloud<PointInT>::Ptr cloud_filtered);
     double calcAvgAccuracy(pcl::PointCloud<PointInT> pointCloud);
-    double calcAvgAccuracy(pcl::PointCloud<PointInT> pointCloud, geometry_msgs::Pose cameraPose);
+    virtual double calcAvgAccuracy(const pcl::PointCloud<PointInT>& pointCloud,
+                                   const geometry_msgs::Pose& cameraPose);
     void transformPointMatVec(tf::Vector3 translation, tf::Matrix3x3 rotation,
                               geometry_msgs::Point32 in, geometry_msgs::Point32& out);
     pcl::PointCloud<PointInT> pointCloudViewportTransform(pcl::PointCloud<PointInT> pointCloud,
                                                           geometry_msgs::Pose cameraPose);
-    void SSMaxMinAccuracy(std::vector<geometry_msgs::PoseArray> sensorsPoses);
+    virtual void SSMaxMinAccuracy(const std::vector<geometry_msgs::PoseArray>& sensorsPoses);
+    virtual float getViewEntropy();
+    virtual std::string getBackendName();
     void visualizeFOV(geometry_msgs::Pose location);
     visualization_msgs::Marker drawLines(std::vector<geometry_msgs::Point> links, int id,
                                          int c_color[]);
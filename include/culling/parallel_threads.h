@@ -0,0 +1,48 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef PARALLEL_THREADS_H_
+#define PARALLEL_THREADS_H_
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pcl
+{
+/** \brief Returns the number of threads a parallel region started by the calling thread would
+    * get: 1 without OpenMP or when the region would be nested deeper than allowed, as in the
+    * queries of a batch. A region of one thread is better run as plain serial code, libgomp
+    * allocating the team of every such region while it reuses the teams of larger ones.
+    */
+inline int getParallelThreads()
+{
+#ifdef _OPENMP
+    if (omp_get_active_level() >= omp_get_max_active_levels())
+        return (1);
+    return (omp_get_max_threads());
+#else
+    return (1);
+#endif
+}
+}  // namespace pcl
+
+#endif
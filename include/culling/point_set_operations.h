@@ -0,0 +1,208 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef POINT_SET_OPERATIONS_H_
+#define POINT_SET_OPERATIONS_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <stdint.h>
+#include <vector>
+
+namespace pcl
+{
+/** \brief Hash set of the positions of a point cloud, for O(1) membership tests.
+    * Points are keyed either by their exact coordinates, which matches comparing x, y and z
+    * with ==, or by the cell of a grid of a given resolution they fall in. Non-finite points
+    * are never members. The table uses open addressing with linear probing and is read only
+    * after build (), so it can be probed from several threads.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::PointHashSet<PointInT> set;
+    * set.setResolution (0.0);
+    * set.build (cloud);
+    * bool member = set.contains (point);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+template <typename PointInT>
+class PointHashSet
+{
+  public:
+    typedef pcl::PointCloud<PointInT> PointCloud;
+
+    /** \brief Empty constructor. */
+    PointHashSet() : resolution_(0), size_(0), mask_(0)
+    {
+    }
+
+    /** \brief Set the size of the grid cells the points are keyed by.
+        * \param[in] resolution the cell size, 0 to key the points by their exact coordinates
+        */
+    inline void setResolution(float resolution)
+    {
+        resolution_ = resolution;
+    }
+
+    /** \brief Returns the size of the grid cells the points are keyed by (0 if exact). */
+    inline float getResolution()
+    {
+        return (resolution_);
+    }
+
+    /** \brief Inserts the points of a cloud, replacing the previous content.
+        * \param[in] cloud the point cloud
+        */
+    void build(const PointCloud& cloud);
+
+    /** \brief Inserts the points of a cloud given by indices, replacing the previous content.
+        * \param[in] cloud the point cloud
+        * \param[in] indices the indices of the points to insert
+        */
+    void build(const PointCloud& cloud, const std::vector<int>& indices);
+
+    /** \brief Returns true if the position (or the grid cell) of a point is in the set.
+        * \param[in] point the point
+        */
+    bool contains(const PointInT& point) const;
+
+    /** \brief Returns the number of distinct positions (or grid cells) in the set. */
+    inline size_t size() const
+    {
+        return (size_);
+    }
+
+  protected:
+    /** \brief Key of a position: the bits of the coordinates or the grid cell (i,j,k). */
+    struct Key
+    {
+        uint32_t k[3];
+        inline bool operator==(const Key& other) const
+        {
+            return (k[0] == other.k[0] && k[1] == other.k[1] && k[2] == other.k[2]);
+        }
+    };
+
+    /** \brief Computes the key of a point, returns false if the point is not finite. */
+    bool getKey(const PointInT& point, Key& key) const;
+
+    /** \brief Returns the first table slot probed for a key. */
+    inline size_t hash(const Key& key) const
+    {
+        uint64_t h = (static_cast<uint64_t>(key.k[0]) * 0x9E3779B97F4A7C15ULL) ^
+                     (static_cast<uint64_t>(key.k[1]) * 0xC2B2AE3D27D4EB4FULL) ^
+                     (static_cast<uint64_t>(key.k[2]) * 0x165667B19E3779F9ULL);
+        h ^= h >> 29;
+        return (static_cast<size_t>(h) & mask_);
+    }
+
+    /** \brief Inserts a point into the table. */
+    void insert(const PointInT& point);
+
+    /** \brief Sizes the table for a number of points. */
+    void reset(size_t num_points);
+
+    float resolution_;
+
+    // keys and occupation of the slots, the number of slots is a power of two
+    std::vector<Key> keys_;
+    std::vector<unsigned char> used_;
+    size_t size_;
+    size_t mask_;
+};
+
+/** \brief Copies the points of a cloud whose position (or grid cell) is not in another cloud,
+    * in the order of the first cloud.
+    * \param[in] cloud_a the cloud whose points are kept
+    * \param[in] cloud_b the cloud whose points are removed
+    * \param[out] output the difference a - b
+    * \param[in] resolution the grid cell size positions are compared at, 0 for exact positions
+    * \ingroup filters
+    */
+template <typename PointInT>
+void pointsDifference(const pcl::PointCloud<PointInT>& cloud_a,
+                      const pcl::PointCloud<PointInT>& cloud_b,
+                      pcl::PointCloud<PointInT>& output, float resolution = 0);
+
+/** \brief Copies the points of a cloud whose position (or grid cell) is also in another cloud,
+    * in the order of the first cloud.
+    * \param[in] cloud_a the cloud whose points are kept
+    * \param[in] cloud_b the cloud the points have to be in
+    * \param[out] output the intersection of a and b
+    * \param[in] resolution the grid cell size positions are compared at, 0 for exact positions
+    * \ingroup filters
+    */
+template <typename PointInT>
+void pointsIntersection(const pcl::PointCloud<PointInT>& cloud_a,
+                        const pcl::PointCloud<PointInT>& cloud_b,
+                        pcl::PointCloud<PointInT>& output, float resolution = 0);
+
+/** \brief Copies the points of a cloud followed by the points of another cloud whose position
+    * (or grid cell) is not in the first one.
+    * \param[in] cloud_a the first cloud
+    * \param[in] cloud_b the second cloud
+    * \param[out] output the union of a and b
+    * \param[in] resolution the grid cell size positions are compared at, 0 for exact positions
+    * \ingroup filters
+    */
+template <typename PointInT>
+void pointsUnion(const pcl::PointCloud<PointInT>& cloud_a,
+                 const pcl::PointCloud<PointInT>& cloud_b, pcl::PointCloud<PointInT>& output,
+                 float resolution = 0);
+
+/** \brief Returns the indices of a set that are not in another set, in the order of the
+    * first set. Both sets hold point indices smaller than num_points.
+    * \param[in] indices_a the indices that are kept
+    * \param[in] indices_b the indices that are removed
+    * \param[in] num_points the number of points of the cloud the indices refer to
+    * \param[out] output the difference a - b
+    * \ingroup filters
+    */
+void indicesDifference(const std::vector<int>& indices_a, const std::vector<int>& indices_b,
+                       size_t num_points, std::vector<int>& output);
+
+/** \brief Returns the indices of a set that are also in another set, in the order of the first
+    * set. Both sets hold point indices smaller than num_points.
+    * \param[in] indices_a the indices that are kept
+    * \param[in] indices_b the indices they have to be in
+    * \param[in] num_points the number of points of the cloud the indices refer to
+    * \param[out] output the intersection of a and b
+    * \ingroup filters
+    */
+void indicesIntersection(const std::vector<int>& indices_a, const std::vector<int>& indices_b,
+                         size_t num_points, std::vector<int>& output);
+
+/** \brief Returns the indices of a set followed by the indices of another set that are not in
+    * the first one. Both sets hold point indices smaller than num_points.
+    * \param[in] indices_a the first set
+    * \param[in] indices_b the second set
+    * \param[in] num_points the number of points of the cloud the indices refer to
+    * \param[out] output the union of a and b
+    * \ingroup filters
+    */
+void indicesUnion(const std::vector<int>& indices_a, const std::vector<int>& indices_b,
+                  size_t num_points, std::vector<int>& output);
+}  // namespace pcl
+#include "culling/point_set_operations.hpp"
+#endif
@@ -0,0 +1,184 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef POINT_SET_OPERATIONS_HPP_
+#define POINT_SET_OPERATIONS_HPP_
+
+#include <culling/point_set_operations.h>
+#include <pcl/common/common.h>
+#include <cmath>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+bool pcl::PointHashSet<PointInT>::getKey(const PointInT& point, Key& key) const
+{
+    if (!isFinite(point))
+        return (false);
+    if (resolution_ > 0)
+    {
+        key.k[0] = static_cast<uint32_t>(static_cast<int>(floor(point.x / resolution_)));
+        key.k[1] = static_cast<uint32_t>(static_cast<int>(floor(point.y / resolution_)));
+        key.k[2] = static_cast<uint32_t>(static_cast<int>(floor(point.z / resolution_)));
+    }
+    else
+    {
+        // adding 0 turns -0 into +0, which compare equal
+        float xyz[3] = {point.x + 0.0f, point.y + 0.0f, point.z + 0.0f};
+        memcpy(key.k, xyz, sizeof(key.k));
+    }
+    return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::PointHashSet<PointInT>::reset(size_t num_points)
+{
+    // at most half of the slots are used
+    size_t num_slots = 16;
+    while (num_slots < 2 * num_points)
+        num_slots *= 2;
+    keys_.resize(num_slots);
+    used_.assign(num_slots, 0);
+    mask_ = num_slots - 1;
+    size_ = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::PointHashSet<PointInT>::insert(const PointInT& point)
+{
+    Key key;
+    if (!getKey(point, key))
+        return;
+    size_t slot = hash(key);
+    while (used_[slot])
+    {
+        if (keys_[slot] == key)
+            return;
+        slot = (slot + 1) & mask_;
+    }
+    used_[slot] = 1;
+    keys_[slot] = key;
+    ++size_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::PointHashSet<PointInT>::build(const PointCloud& cloud)
+{
+    reset(cloud.points.size());
+    for (size_t i = 0; i < cloud.points.size(); ++i)
+        insert(cloud.points[i]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::PointHashSet<PointInT>::build(const PointCloud& cloud, const std::vector<int>& indices)
+{
+    reset(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+        insert(cloud.points[indices[i]]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+bool pcl::PointHashSet<PointInT>::contains(const PointInT& point) const
+{
+    Key key;
+    if (used_.empty() || !getKey(point, key))
+        return (false);
+    size_t slot = hash(key);
+    while (used_[slot])
+    {
+        if (keys_[slot] == key)
+            return (true);
+        slot = (slot + 1) & mask_;
+    }
+    return (false);
+}
+
+namespace pcl
+{
+namespace detail
+{
+/** \brief Copies the points of cloud_a whose membership in the set of cloud_b is keep_members,
+    * appending them to output. The cloud is probed in parallel and copied in order.
+    */
+template <typename PointInT>
+void selectPoints(const pcl::PointCloud<PointInT>& cloud_a, const PointHashSet<PointInT>& set,
+                  bool keep_members, pcl::PointCloud<PointInT>& output)
+{
+    int num_points = static_cast<int>(cloud_a.points.size());
+    std::vector<unsigned char> keep(num_points);
+#pragma omp parallel for
+    for (int i = 0; i < num_points; ++i)
+        keep[i] = (set.contains(cloud_a.points[i]) == keep_members);
+
+    for (int i = 0; i < num_points; ++i)
+        if (keep[i])
+            output.points.push_back(cloud_a.points[i]);
+    output.width = static_cast<uint32_t>(output.points.size());
+    output.height = 1;
+}
+}  // namespace detail
+}  // namespace pcl
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::pointsDifference(const pcl::PointCloud<PointInT>& cloud_a,
+                           const pcl::PointCloud<PointInT>& cloud_b,
+                           pcl::PointCloud<PointInT>& output, float resolution)
+{
+    PointHashSet<PointInT> set;
+    set.setResolution(resolution);
+    set.build(cloud_b);
+    output.points.clear();
+    detail::selectPoints(cloud_a, set, false, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::pointsIntersection(const pcl::PointCloud<PointInT>& cloud_a,
+                             const pcl::PointCloud<PointInT>& cloud_b,
+                             pcl::PointCloud<PointInT>& output, float resolution)
+{
+    PointHashSet<PointInT> set;
+    set.setResolution(resolution);
+    set.build(cloud_b);
+    output.points.clear();
+    detail::selectPoints(cloud_a, set, true, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::pointsUnion(const pcl::PointCloud<PointInT>& cloud_a,
+                      const pcl::PointCloud<PointInT>& cloud_b,
+                      pcl::PointCloud<PointInT>& output, float resolution)
+{
+    PointHashSet<PointInT> set;
+    set.setResolution(resolution);
+    set.build(cloud_a);
+    output.points.assign(cloud_a.points.begin(), cloud_a.points.end());
+    detail::selectPoints(cloud_b, set, false, output);
+}
+
+#endif
@@ -0,0 +1,176 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef VIEW_STATISTICS_H_
+#define VIEW_STATISTICS_H_
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace pcl
+{
+/** \brief Depth, accuracy and entropy statistics of the points visible from a view.
+    * The occlusion estimation adds the depth of every visible point as it finds it, so one
+    * extraction gives all the metrics of the view without another pass over the cloud.
+    * The accuracy error of a point is the standard deviation 0.0000285 * d^2 of the depth
+    * sensor, and its entropy is the binary entropy of its accuracy normalised by the largest
+    * error of the view set, as in the CUDA ray traversal.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::ViewStatistics stats (max_accuracy_error);
+    * for (size_t i = 0; i < depths.size (); ++i)
+    *   stats.add (depths[i]);
+    * double mean_error = stats.getAvgAccuracyError ();
+    * \endcode
+    *
+    * \ingroup filters
+    */
+class ViewStatistics
+{
+  public:
+    /** \brief Empty constructor, without entropy. */
+    ViewStatistics()
+    {
+        reset(0);
+    }
+
+    /** \brief Creates empty statistics.
+        * \param[in] max_accuracy_error the error that normalises the entropy, 0 for none
+        */
+    explicit ViewStatistics(double max_accuracy_error)
+    {
+        reset(max_accuracy_error);
+    }
+
+    /** \brief Removes all points and sets the error that normalises the entropy.
+        * \param[in] max_accuracy_error the error that normalises the entropy, 0 for none
+        */
+    inline void reset(double max_accuracy_error)
+    {
+        max_accuracy_error_ = max_accuracy_error;
+        count_ = 0;
+        min_depth_ = std::numeric_limits<double>::max();
+        max_depth_ = -std::numeric_limits<double>::max();
+        depth_sum_ = 0;
+        error_sum_ = 0;
+        entropy_ = 0;
+    }
+
+    /** \brief Returns the accuracy error of a depth measurement.
+        * \param[in] depth the depth of the point
+        */
+    static inline double accuracyError(double depth)
+    {
+        return (0.0000285 * depth * depth);
+    }
+
+    /** \brief Adds a visible point.
+        * \param[in] depth the depth of the point in the sensor frame
+        */
+    inline void add(double depth)
+    {
+        ++count_;
+        if (min_depth_ > depth)
+            min_depth_ = depth;
+        if (max_depth_ < depth)
+            max_depth_ = depth;
+        depth_sum_ += depth;
+        double error = accuracyError(depth);
+        error_sum_ += error;
+        if (max_accuracy_error_ > 0)
+        {
+            // the entropy vanishes at both ends, where the logarithms are not defined
+            double norm = (max_accuracy_error_ - error) / max_accuracy_error_;
+            if (norm > 0 && norm < 1)
+                entropy_ += -norm * std::log(norm) - (1 - norm) * std::log(1 - norm);
+        }
+    }
+
+    /** \brief Adds the points of other statistics with the same normalisation.
+        * \param[in] other the statistics to merge
+        */
+    inline void merge(const ViewStatistics& other)
+    {
+        count_ += other.count_;
+        if (min_depth_ > other.min_depth_)
+            min_depth_ = other.min_depth_;
+        if (max_depth_ < other.max_depth_)
+            max_depth_ = other.max_depth_;
+        depth_sum_ += other.depth_sum_;
+        error_sum_ += other.error_sum_;
+        entropy_ += other.entropy_;
+    }
+
+    /** \brief Returns the number of visible points. */
+    inline size_t getCount() const
+    {
+        return (count_);
+    }
+
+    /** \brief Returns the smallest depth, or 0 without points. */
+    inline double getMinDepth() const
+    {
+        return (count_ > 0 ? min_depth_ : 0);
+    }
+
+    /** \brief Returns the largest depth, or 0 without points. */
+    inline double getMaxDepth() const
+    {
+        return (count_ > 0 ? max_depth_ : 0);
+    }
+
+    /** \brief Returns the mean depth, or 0 without points. */
+    inline double getMeanDepth() const
+    {
+        return (count_ > 0 ? depth_sum_ / count_ : 0);
+    }
+
+    /** \brief Returns the sum of the accuracy errors of the points. */
+    inline double getAccuracyErrorSum() const
+    {
+        return (error_sum_);
+    }
+
+    /** \brief Returns the mean accuracy error of the points, as calcAvgAccuracy (). */
+    inline double getAvgAccuracyError() const
+    {
+        return (error_sum_ / count_);
+    }
+
+    /** \brief Returns the total entropy of the view. */
+    inline double getEntropy() const
+    {
+        return (entropy_);
+    }
+
+  protected:
+    double max_accuracy_error_;
+    size_t count_;
+    double min_depth_, max_depth_;
+    double depth_sum_;
+    double error_sum_;
+    double entropy_;
+};
+}  // namespace pcl
+#endif
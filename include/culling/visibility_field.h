@@ -0,0 +1,271 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef VISIBILITY_FIELD_H_
+#define VISIBILITY_FIELD_H_
+
+#include <culling/voxel_grid_occlusion_estimation.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+/** \brief Directional visibility field of a static model.
+    * For every occupied voxel of the model a ray is cast in each of a fixed set of
+    * directions (a Fibonacci sphere) and the distance up to which each direction is
+    * unobstructed is stored, quantized to a byte of the maximum range (255 = free up to the
+    * maximum range). The occlusion of a voxel seen from a viewpoint is then a direction
+    * lookup and a comparison with the distance of the viewpoint instead of a ray traversal;
+    * the viewpoint still has to be tested against the frustum separately. Storing the
+    * distance rather than a single bit keeps geometry behind a close viewpoint from
+    * occluding the voxel.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::VisibilityFieldT<PointInT> field;
+    * field.setInputCloud (model);
+    * field.setLeafSize (0.1);
+    * field.setNumberOfDirections (128);
+    * field.setMaxRange (8.0);
+    * field.compute ();
+    * field.save ("model.vfield");
+    *
+    * int state;
+    * field.getVisibility (state, point, viewpoint);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+template <typename PointInT>
+class VisibilityFieldT
+{
+    typedef pcl::PointCloud<PointInT> PointCloud;
+    typedef typename PointCloud::Ptr PointCloudPtr;
+    typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+  public:
+    typedef std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > Directions;
+    typedef std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > Voxels;
+
+    /** \brief Empty constructor. */
+    VisibilityFieldT()
+        : leaf_size_(0.1f), max_range_(8.0f), num_directions_(128), grid_initialized_(false)
+    {
+        min_b_.setZero();
+        div_b_.setZero();
+    }
+
+    /** \brief Provide the model the visibility field is computed for.
+        * \param[in] cloud the model point cloud
+        */
+    inline void setInputCloud(const PointCloudConstPtr& cloud)
+    {
+        input_ = cloud;
+        grid_initialized_ = false;
+    }
+
+    /** \brief Set the size of the (cubic) voxels of the field.
+        * \param[in] leaf_size the voxel size
+        */
+    inline void setLeafSize(float leaf_size)
+    {
+        leaf_size_ = leaf_size;
+        grid_initialized_ = false;
+    }
+
+    /** \brief Returns the size of the voxels of the field. */
+    inline float getLeafSize()
+    {
+        return (leaf_size_);
+    }
+
+    /** \brief Set the distance up to which the directions of a voxel must be unobstructed.
+        * \param[in] max_range the maximum range (usually the sensor far limit)
+        */
+    inline void setMaxRange(float max_range)
+    {
+        max_range_ = max_range;
+    }
+
+    /** \brief Returns the distance up to which the directions are unobstructed. */
+    inline float getMaxRange()
+    {
+        return (max_range_);
+    }
+
+    /** \brief Set the number of directions per voxel (1 to 256).
+        * \param[in] num_directions the number of points on the Fibonacci sphere
+        */
+    inline void setNumberOfDirections(int num_directions)
+    {
+        num_directions_ = std::max(1, std::min(num_directions, 256));
+    }
+
+    /** \brief Returns the number of directions per voxel. */
+    inline int getNumberOfDirections()
+    {
+        return (num_directions_);
+    }
+
+    /** \brief Returns the number of voxels in the field (0 before compute () or load ()). */
+    inline size_t size() const
+    {
+        return (voxels_.size());
+    }
+
+    /** \brief Returns the hash of the voxel coordinates of the field, see hashVoxels (). */
+    inline uint64_t getVoxelHash() const
+    {
+        return (hashVoxels(voxels_));
+    }
+
+    /** \brief Returns the directions of the field, in the order of the stored distances. */
+    inline const Directions& getDirections()
+    {
+        return (directions_);
+    }
+
+    /** \brief Creates evenly spread unit directions on the Fibonacci sphere.
+        * \param[in] num_directions the number of directions
+        * \param[out] directions the directions
+        */
+    static void fibonacciSphere(int num_directions, Directions& directions);
+
+    /** \brief Hashes a set of voxel coordinates independently of their order, so that a stored
+        * field can be matched against the voxels of the model it is loaded for.
+        * \param[in] voxels the (i,j,k) voxel coordinates
+        */
+    static uint64_t hashVoxels(const Voxels& voxels);
+
+    /** \brief Computes the unobstructed distances of every occupied voxel of the input cloud.
+        * \return 0 on success, -1 if no input cloud was given
+        */
+    int compute();
+
+    /** \brief Returns the state (free = 0, occluded = 1) of the voxel containing a point seen
+        * from a viewpoint, using the direction of the field nearest to the viewpoint.
+        * \param[out] out_state The state of the voxel.
+        * \param[in] point The point coordinate (x,y,z).
+        * \param[in] viewpoint The sensor origin.
+        * \return 0 on success, -1 if the point is not in an occupied voxel of the field
+        */
+    int getVisibility(int& out_state, const Eigen::Vector4f& point,
+                      const Eigen::Vector4f& viewpoint) const;
+
+    /** \brief Compares the field against the exact ray traversal in the model voxel grid
+        * for all voxels within the maximum range of each viewpoint.
+        * \param[in] viewpoints The sensor origins.
+        * \param[out] out_false_visible Voxels the field reports visible but are occluded.
+        * \param[out] out_false_occluded Voxels the field reports occluded but are visible.
+        * \return the fraction of compared voxels with a wrong state, -1 on error
+        */
+    double measureError(const Directions& viewpoints, size_t& out_false_visible,
+                        size_t& out_false_occluded);
+
+    /** \brief Writes the field to a binary file.
+        * \param[in] file_name the file name
+        * \return 0 on success, -1 on error
+        */
+    int save(const std::string& file_name);
+
+    /** \brief Reads a field written by save (). The caller still has to check that the field
+        * belongs to its model, e.g. by comparing size () and getVoxelHash () with its own voxels.
+        * \param[in] file_name the file name
+        * \return 0 on success, -1 on error (including a file truncated or not matching its
+        * stored voxel count and hash)
+        */
+    int load(const std::string& file_name);
+
+  protected:
+    /** \brief Builds the voxel grid of the input cloud used for the ray casting. */
+    int initializeGrid();
+
+    /** \brief Creates the Fibonacci sphere and the direction lookup table. */
+    void initializeDirections();
+
+    /** \brief Fills the voxel layout from the voxel coordinates of the field. */
+    void initializeLayout();
+
+    /** \brief Returns the index of the field voxel (i,j,k), -1 if it is not occupied. */
+    inline int getVoxelIndex(const Eigen::Vector3i& ijk) const
+    {
+        Eigen::Vector3i d = ijk - min_b_;
+        if (d[0] < 0 || d[1] < 0 || d[2] < 0 || d[0] >= div_b_[0] || d[1] >= div_b_[1] ||
+            d[2] >= div_b_[2])
+            return (-1);
+        return (layout_[(d[2] * div_b_[1] + d[1]) * div_b_[0] + d[0]]);
+    }
+
+    /** \brief Returns the index of the lookup table cell of a direction, the direction is
+        * mapped onto the octahedron and unfolded into a square.
+        * \param[in] direction The normalized direction.
+        */
+    inline int getLookupCell(const Eigen::Vector4f& direction) const
+    {
+        float norm = fabs(direction[0]) + fabs(direction[1]) + fabs(direction[2]);
+        float u = direction[0] / norm;
+        float v = direction[1] / norm;
+        if (direction[2] < 0)
+        {
+            float fu = (1.0f - fabs(v)) * (u >= 0 ? 1.0f : -1.0f);
+            float fv = (1.0f - fabs(u)) * (v >= 0 ? 1.0f : -1.0f);
+            u = fu;
+            v = fv;
+        }
+        int cu = std::min(static_cast<int>((u * 0.5f + 0.5f) * lookup_resolution_),
+                          lookup_resolution_ - 1);
+        int cv = std::min(static_cast<int>((v * 0.5f + 0.5f) * lookup_resolution_),
+                          lookup_resolution_ - 1);
+        return (cv * lookup_resolution_ + cu);
+    }
+
+    // resolution of the direction lookup table per axis
+    static const int lookup_resolution_ = 128;
+
+    // model the field is computed for
+    PointCloudConstPtr input_;
+
+    // voxel grid of the model, used for the ray casting and the error measurement
+    VoxelGridOcclusionEstimationT<PointInT> grid_;
+
+    float leaf_size_;
+    float max_range_;
+    int num_directions_;
+    bool grid_initialized_;
+
+    // directions on the Fibonacci sphere and the index of the nearest one per lookup cell
+    Directions directions_;
+    std::vector<unsigned char> lookup_;
+
+    // voxel coordinates, their quantized distances (num_directions_ per voxel) and the dense
+    // layout of the bounding box mapping a voxel to its index (-1 if not occupied)
+    Voxels voxels_;
+    std::vector<unsigned char> distances_;
+    std::vector<int> layout_;
+    Eigen::Vector3i min_b_, div_b_;
+};
+}  // namespace pcl
+#include "culling/visibility_field.hpp"
+#endif
@@ -0,0 +1,364 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef VISIBILITY_FIELD_HPP_
+#define VISIBILITY_FIELD_HPP_
+
+#include <culling/visibility_field.h>
+#include <fstream>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VisibilityFieldT<PointInT>::initializeGrid()
+{
+    if (!input_)
+    {
+        PCL_ERROR("No input cloud given for the visibility field! \n");
+        return -1;
+    }
+    if (!grid_initialized_)
+    {
+        grid_.setInputCloud(input_);
+        grid_.setLeafSize(leaf_size_, leaf_size_, leaf_size_);
+        grid_.setTraverseFromSensor(true);
+        grid_.initializeVoxelGrid();
+        grid_initialized_ = true;
+    }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VisibilityFieldT<PointInT>::fibonacciSphere(int num_directions, Directions& directions)
+{
+    // points spaced by the golden angle around the z axis, at equal steps in z
+    const float golden_angle = static_cast<float>(M_PI * (3.0 - sqrt(5.0)));
+    directions.resize(num_directions);
+    for (int i = 0; i < num_directions; ++i)
+    {
+        float z = 1.0f - (2.0f * i + 1.0f) / num_directions;
+        float r = sqrt(std::max(0.0f, 1.0f - z * z));
+        float phi = golden_angle * i;
+        directions[i] = Eigen::Vector4f(r * cos(phi), r * sin(phi), z, 0.0f);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+uint64_t pcl::VisibilityFieldT<PointInT>::hashVoxels(const Voxels& voxels)
+{
+    // sum of the mixed (splitmix64) coordinates of every voxel, independent of the voxel order
+    uint64_t hash = voxels.size();
+    for (size_t v = 0; v < voxels.size(); ++v)
+    {
+        uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(voxels[v][0])) << 42) ^
+                       (static_cast<uint64_t>(static_cast<uint32_t>(voxels[v][1])) << 21) ^
+                       static_cast<uint64_t>(static_cast<uint32_t>(voxels[v][2]));
+        key += 0x9e3779b97f4a7c15ULL;
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        hash += key ^ (key >> 31);
+    }
+    return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VisibilityFieldT<PointInT>::initializeDirections()
+{
+    fibonacciSphere(num_directions_, directions_);
+
+    // nearest direction for the center of every cell of the octahedral lookup table
+    lookup_.resize(lookup_resolution_ * lookup_resolution_);
+    for (int cv = 0; cv < lookup_resolution_; ++cv)
+        for (int cu = 0; cu < lookup_resolution_; ++cu)
+        {
+            float u = ((cu + 0.5f) / lookup_resolution_) * 2.0f - 1.0f;
+            float v = ((cv + 0.5f) / lookup_resolution_) * 2.0f - 1.0f;
+            Eigen::Vector4f direction(u, v, 1.0f - fabs(u) - fabs(v), 0.0f);
+            if (direction[2] < 0)
+            {
+                direction[0] = (1.0f - fabs(v)) * (u >= 0 ? 1.0f : -1.0f);
+                direction[1] = (1.0f - fabs(u)) * (v >= 0 ? 1.0f : -1.0f);
+            }
+            direction.normalize();
+
+            int nearest = 0;
+            float best = -2.0f;
+            for (int i = 0; i < num_directions_; ++i)
+            {
+                float cosine = direction.dot(directions_[i]);
+                if (cosine > best)
+                {
+                    best = cosine;
+                    nearest = i;
+                }
+            }
+            lookup_[cv * lookup_resolution_ + cu] = static_cast<unsigned char>(nearest);
+        }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VisibilityFieldT<PointInT>::initializeLayout()
+{
+    if (voxels_.empty())
+    {
+        min_b_.setZero();
+        div_b_.setZero();
+        layout_.clear();
+        return;
+    }
+    min_b_ = voxels_[0];
+    Eigen::Vector3i max_b = voxels_[0];
+    for (size_t v = 1; v < voxels_.size(); ++v)
+    {
+        min_b_ = min_b_.cwiseMin(voxels_[v]);
+        max_b = max_b.cwiseMax(voxels_[v]);
+    }
+    div_b_ = max_b - min_b_ + Eigen::Vector3i::Ones();
+    layout_.assign(static_cast<size_t>(div_b_[0]) * div_b_[1] * div_b_[2], -1);
+    for (size_t v = 0; v < voxels_.size(); ++v)
+    {
+        Eigen::Vector3i d = voxels_[v] - min_b_;
+        layout_[(d[2] * div_b_[1] + d[1]) * div_b_[0] + d[0]] = static_cast<int>(v);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VisibilityFieldT<PointInT>::compute()
+{
+    if (initializeGrid() == -1)
+        return -1;
+    initializeDirections();
+
+    // the occupied voxels of the model, one per voxel grid centroid
+    PointCloud centroids = grid_.getFilteredPointCloud();
+    voxels_.resize(centroids.points.size());
+    for (size_t v = 0; v < centroids.points.size(); ++v)
+        voxels_[v] = grid_.getGridCoordinates(centroids.points[v].x, centroids.points[v].y,
+                                              centroids.points[v].z);
+    initializeLayout();
+
+    distances_.assign(voxels_.size() * num_directions_, 0);
+    int num_voxels = static_cast<int>(voxels_.size());
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int v = 0; v < num_voxels; ++v)
+    {
+        unsigned char* distances = &distances_[static_cast<size_t>(v) * num_directions_];
+        for (int i = 0; i < num_directions_; ++i)
+        {
+            int state = 1;
+            float distance = 0.0f;
+            grid_.lineOfSightEstimation(state, distance, voxels_[v], directions_[i], max_range_);
+
+            // rounded down, so that the stored distance never reaches into the occupied voxel
+            if (state == 0)
+                distances[i] = 255;
+            else
+                distances[i] = static_cast<unsigned char>(
+                    std::min(254.0f, floorf(distance / max_range_ * 255.0f)));
+        }
+    }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VisibilityFieldT<PointInT>::getVisibility(int& out_state, const Eigen::Vector4f& point,
+                                                   const Eigen::Vector4f& viewpoint) const
+{
+    float inverse_leaf_size = 1.0f / leaf_size_;
+    Eigen::Vector3i ijk(static_cast<int>(floor(point[0] * inverse_leaf_size)),
+                        static_cast<int>(floor(point[1] * inverse_leaf_size)),
+                        static_cast<int>(floor(point[2] * inverse_leaf_size)));
+    int index = getVoxelIndex(ijk);
+    if (index == -1)
+        return -1;
+
+    // direction from the voxel center to the viewpoint
+    Eigen::Vector4f center((ijk[0] + 0.5f) * leaf_size_, (ijk[1] + 0.5f) * leaf_size_,
+                           (ijk[2] + 0.5f) * leaf_size_, 0.0f);
+    Eigen::Vector4f direction = viewpoint - center;
+    direction[3] = 0.0f;
+    float distance = direction.norm();
+    direction /= distance;
+
+    // the voxel is visible if the viewpoint lies within the unobstructed distance
+    int i = lookup_[getLookupCell(direction)];
+    unsigned char free = distances_[static_cast<size_t>(index) * num_directions_ + i];
+    out_state = (free == 255 || distance <= free * (max_range_ / 255.0f)) ? 0 : 1;
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+double pcl::VisibilityFieldT<PointInT>::measureError(const Directions& viewpoints,
+                                                     size_t& out_false_visible,
+                                                     size_t& out_false_occluded)
+{
+    out_false_visible = 0;
+    out_false_occluded = 0;
+    if (voxels_.empty() || initializeGrid() == -1)
+        return -1.0;
+
+    size_t compared = 0;
+    std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > targets;
+    std::vector<int> states;
+    for (size_t p = 0; p < viewpoints.size(); ++p)
+    {
+        // exact traversal from the viewpoint to every voxel within range
+        targets.clear();
+        for (size_t v = 0; v < voxels_.size(); ++v)
+        {
+            Eigen::Vector4f center = grid_.getCentroidCoordinate(voxels_[v]);
+            if ((center - viewpoints[p]).head<3>().norm() <= max_range_)
+                targets.push_back(voxels_[v]);
+        }
+        grid_.setSensorOrigin(viewpoints[p]);
+        grid_.occlusionEstimation(states, targets, 8);
+
+        for (size_t t = 0; t < targets.size(); ++t)
+        {
+            if (states[t] == -1)
+                continue;
+            int state;
+            if (getVisibility(state, grid_.getCentroidCoordinate(targets[t]), viewpoints[p]) == -1)
+                continue;
+            compared++;
+            if (state == 0 && states[t] == 1)
+                out_false_visible++;
+            else if (state == 1 && states[t] == 0)
+                out_false_occluded++;
+        }
+    }
+    if (compared == 0)
+        return 0.0;
+    return static_cast<double>(out_false_visible + out_false_occluded) / compared;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VisibilityFieldT<PointInT>::save(const std::string& file_name)
+{
+    std::ofstream file(file_name.c_str(), std::ios::out | std::ios::binary);
+    if (!file)
+    {
+        PCL_ERROR("Could not open %s for writing the visibility field \n", file_name.c_str());
+        return -1;
+    }
+    const char magic[4] = {'V', 'F', 'L', 'D'};
+    uint32_t version = 2;
+    uint32_t num_directions = num_directions_;
+    uint64_t num_voxels = voxels_.size();
+    uint64_t voxel_hash = hashVoxels(voxels_);
+    file.write(magic, sizeof(magic));
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    file.write(reinterpret_cast<const char*>(&num_directions), sizeof(num_directions));
+    file.write(reinterpret_cast<const char*>(&leaf_size_), sizeof(leaf_size_));
+    file.write(reinterpret_cast<const char*>(&max_range_), sizeof(max_range_));
+    file.write(reinterpret_cast<const char*>(&num_voxels), sizeof(num_voxels));
+    file.write(reinterpret_cast<const char*>(&voxel_hash), sizeof(voxel_hash));
+    for (size_t v = 0; v < voxels_.size(); ++v)
+    {
+        int32_t ijk[3] = {voxels_[v][0], voxels_[v][1], voxels_[v][2]};
+        file.write(reinterpret_cast<const char*>(ijk), sizeof(ijk));
+    }
+    if (!distances_.empty())
+        file.write(reinterpret_cast<const char*>(&distances_[0]), distances_.size());
+    if (!file)
+    {
+        PCL_ERROR("Failed writing the visibility field to %s \n", file_name.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VisibilityFieldT<PointInT>::load(const std::string& file_name)
+{
+    std::ifstream file(file_name.c_str(), std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        PCL_ERROR("Could not open %s for reading the visibility field \n", file_name.c_str());
+        return -1;
+    }
+    char magic[4];
+    uint32_t version, num_directions;
+    uint64_t num_voxels, voxel_hash;
+    float leaf_size, max_range;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&num_directions), sizeof(num_directions));
+    file.read(reinterpret_cast<char*>(&leaf_size), sizeof(leaf_size));
+    file.read(reinterpret_cast<char*>(&max_range), sizeof(max_range));
+    file.read(reinterpret_cast<char*>(&num_voxels), sizeof(num_voxels));
+    file.read(reinterpret_cast<char*>(&voxel_hash), sizeof(voxel_hash));
+    if (!file || magic[0] != 'V' || magic[1] != 'F' || magic[2] != 'L' || magic[3] != 'D' ||
+        version != 2 || num_directions < 1 || num_directions > 256)
+    {
+        PCL_ERROR("%s is not a visibility field \n", file_name.c_str());
+        return -1;
+    }
+
+    // every voxel takes its coordinates and a distance per direction, a count the rest of the
+    // file cannot hold is corrupt and must not size the buffers
+    std::streampos header_end = file.tellg();
+    file.seekg(0, std::ios::end);
+    uint64_t remaining = static_cast<uint64_t>(file.tellg() - header_end);
+    file.seekg(header_end);
+    if (num_voxels > remaining / (3 * sizeof(int32_t) + num_directions))
+    {
+        PCL_ERROR("Truncated visibility field in %s \n", file_name.c_str());
+        return -1;
+    }
+
+    setNumberOfDirections(static_cast<int>(num_directions));
+    if (leaf_size != leaf_size_)
+        grid_initialized_ = false;
+    leaf_size_ = leaf_size;
+    max_range_ = max_range;
+    voxels_.resize(num_voxels);
+    for (size_t v = 0; v < voxels_.size(); ++v)
+    {
+        int32_t ijk[3];
+        file.read(reinterpret_cast<char*>(ijk), sizeof(ijk));
+        voxels_[v] = Eigen::Vector3i(ijk[0], ijk[1], ijk[2]);
+    }
+    distances_.resize(voxels_.size() * num_directions_);
+    if (!distances_.empty())
+        file.read(reinterpret_cast<char*>(&distances_[0]), distances_.size());
+    if (!file || hashVoxels(voxels_) != voxel_hash)
+    {
+        PCL_ERROR("Truncated or corrupt visibility field in %s \n", file_name.c_str());
+        voxels_.clear();
+        distances_.clear();
+        initializeLayout();
+        return -1;
+    }
+    initializeDirections();
+    initializeLayout();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,210 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef VISIBILITY_HEATMAP_H_
+#define VISIBILITY_HEATMAP_H_
+
+#include <culling/visibility_field.h>
+#include <culling/voxel_grid_occlusion_estimation.h>
+#include <pcl/point_types.h>
+#include <vector>
+
+namespace pcl
+{
+/** \brief Visibility heatmap of the free space around a static model.
+    * Counts for every free cell of a grid around the model how many model voxels can be
+    * seen from it. Visibility is reciprocal, so instead of a traversal from every candidate
+    * cell to every model voxel, rays are cast once from each model voxel outward in a fixed
+    * set of directions (a Fibonacci sphere) through free space up to the maximum range,
+    * and every free cell a ray passes is counted once per model voxel. The sensor field of
+    * view is not taken into account.
+    *
+    * The directions are fixed, so the rays of a model voxel spread apart with the distance:
+    * about r * sqrt (4 pi / directions) apart at range r. Once that exceeds the leaf size,
+    * cells between the rays are missed and cells far from the model are undercounted (about
+    * 0.6 m for 0.1 m cells and 512 directions); more directions push that distance out.
+    * The counts of the grid (4 bytes per cell) are shared by all threads, a thread only
+    * keeps a bit per cell of a window of the maximum range around the model voxel it casts.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::VisibilityHeatmapT<PointInT> heatmap;
+    * heatmap.setInputCloud (model);
+    * heatmap.setLeafSize (0.1);
+    * heatmap.setMaxRange (8.0);
+    * heatmap.setNumberOfDirections (512);
+    * heatmap.setPadding (1.0);
+    * heatmap.compute ();
+    *
+    * pcl::PointCloud<pcl::PointXYZI> cells;
+    * heatmap.getHeatmap (cells);
+    * \endcode
+    *
+    * \ingroup filters
+    */
+template <typename PointInT>
+class VisibilityHeatmapT
+{
+    typedef pcl::PointCloud<PointInT> PointCloud;
+    typedef typename PointCloud::Ptr PointCloudPtr;
+    typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+  public:
+    /** \brief Empty constructor. */
+    VisibilityHeatmapT()
+        : leaf_size_(0.1f), max_range_(8.0f), padding_(1.0f), num_directions_(512)
+    {
+        min_b_.setZero();
+        div_b_.setZero();
+    }
+
+    /** \brief Provide the model the heatmap is computed for.
+        * \param[in] cloud the model point cloud
+        */
+    inline void setInputCloud(const PointCloudConstPtr& cloud)
+    {
+        input_ = cloud;
+    }
+
+    /** \brief Set the size of the (cubic) cells of the heatmap and the model voxels.
+        * \param[in] leaf_size the cell size
+        */
+    inline void setLeafSize(float leaf_size)
+    {
+        leaf_size_ = leaf_size;
+    }
+
+    /** \brief Set the distance up to which a model voxel can be seen (the sensor far limit).
+        * \param[in] max_range the maximum range
+        */
+    inline void setMaxRange(float max_range)
+    {
+        max_range_ = max_range;
+    }
+
+    /** \brief Set the distance the heatmap grid extends beyond the model bounding box.
+        * \param[in] padding the padding in meters
+        */
+    inline void setPadding(float padding)
+    {
+        padding_ = padding;
+    }
+
+    /** \brief Set the number of rays cast from every model voxel.
+        * \param[in] num_directions the number of points on the Fibonacci sphere
+        */
+    inline void setNumberOfDirections(int num_directions)
+    {
+        num_directions_ = std::max(1, num_directions);
+    }
+
+    /** \brief Casts the rays of all model voxels and accumulates the visible counts.
+        * \return 0 on success, -1 if no input cloud was given
+        */
+    int compute();
+
+    /** \brief Returns the number of model voxels visible from the cell containing a position,
+        * 0 outside of the heatmap grid.
+        * \param[in] position The position (x,y,z).
+        */
+    inline unsigned int getVisibleCount(const Eigen::Vector4f& position)
+    {
+        Eigen::Vector3i d(static_cast<int>(floor(position[0] / leaf_size_)) - min_b_[0],
+                          static_cast<int>(floor(position[1] / leaf_size_)) - min_b_[1],
+                          static_cast<int>(floor(position[2] / leaf_size_)) - min_b_[2]);
+        if (d[0] < 0 || d[1] < 0 || d[2] < 0 || d[0] >= div_b_[0] || d[1] >= div_b_[1] ||
+            d[2] >= div_b_[2])
+            return (0);
+        return (counts_[(d[2] * div_b_[1] + d[1]) * div_b_[0] + d[0]]);
+    }
+
+    /** \brief Returns the centers of all cells that see at least one model voxel, with the
+        * number of visible model voxels as intensity.
+        * \param[out] cloud the heatmap cells
+        */
+    void getHeatmap(pcl::PointCloud<pcl::PointXYZI>& cloud);
+
+    /** \brief Returns the visible counts of all cells, x varying fastest. */
+    inline const std::vector<unsigned int>& getCounts()
+    {
+        return (counts_);
+    }
+
+    /** \brief Returns the minimum (i,j,k) cell coordinates of the heatmap grid. */
+    inline Eigen::Vector3i getMinBoxCoordinates()
+    {
+        return (min_b_);
+    }
+
+    /** \brief Returns the number of cells of the heatmap grid along each axis. */
+    inline Eigen::Vector3i getNrDivisions()
+    {
+        return (div_b_);
+    }
+
+  protected:
+    /** \brief Casts a ray from a model voxel and collects the free cells it passes that no
+        * other ray of the model voxel passed yet.
+        * \param[in] source The model voxel (i,j,k) the ray starts from.
+        * \param[in] direction The normalized direction of the ray.
+        * \param[in] window_min The minimum (i,j,k) cell of the window around the model voxel.
+        * \param[in] window_div The number of cells of the window along each axis.
+        * \param[in,out] visited Marks the cells of the window collected for the model voxel.
+        * \param[in,out] cells The indices of the collected cells in the heatmap grid.
+        */
+    void castRay(const Eigen::Vector3i& source, const Eigen::Vector4f& direction,
+                 const Eigen::Vector3i& window_min, const Eigen::Vector3i& window_div,
+                 std::vector<bool>& visited, std::vector<size_t>& cells);
+
+    /** \brief Returns the (i,j,k) coordinates of a cell of the heatmap grid.
+        * \param[in] cell The index of the cell, x varying fastest.
+        */
+    inline Eigen::Vector3i cellCoordinates(size_t cell) const
+    {
+        size_t slice = static_cast<size_t>(div_b_[0]) * div_b_[1];
+        return (min_b_ + Eigen::Vector3i(static_cast<int>(cell % div_b_[0]),
+                                         static_cast<int>(cell % slice / div_b_[0]),
+                                         static_cast<int>(cell / slice)));
+    }
+
+    // model the heatmap is computed for
+    PointCloudConstPtr input_;
+
+    // voxel grid of the model, used for the occupancy of the cells
+    VoxelGridOcclusionEstimationT<PointInT> grid_;
+    Eigen::Vector3i model_min_b_, model_max_b_;
+
+    float leaf_size_;
+    float max_range_;
+    float padding_;
+    int num_directions_;
+
+    // directions on the Fibonacci sphere
+    std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > directions_;
+
+    // visible counts of the cells and the bounds of the heatmap grid
+    std::vector<unsigned int> counts_;
+    Eigen::Vector3i min_b_, div_b_;
+};
+}  // namespace pcl
+#include "culling/visibility_heatmap.hpp"
+#endif
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef VISIBILITY_HEATMAP_HPP_
+#define VISIBILITY_HEATMAP_HPP_
+
+#include <culling/visibility_heatmap.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VisibilityHeatmapT<PointInT>::compute()
+{
+    if (!input_)
+    {
+        PCL_ERROR("No input cloud given for the visibility heatmap! \n");
+        return -1;
+    }
+
+    grid_.setInputCloud(input_);
+    grid_.setLeafSize(leaf_size_, leaf_size_, leaf_size_);
+    grid_.initializeVoxelGrid();
+    VisibilityFieldT<PointInT>::fibonacciSphere(num_directions_, directions_);
+
+    // the heatmap grid covers the model bounding box and the padding around it
+    int pad = static_cast<int>(ceil(padding_ / leaf_size_));
+    model_min_b_ = grid_.getMinBoxCoordinates();
+    model_max_b_ = grid_.getMaxBoxCoordinates();
+    min_b_ = model_min_b_ - Eigen::Vector3i::Constant(pad);
+    div_b_ = model_max_b_ + Eigen::Vector3i::Constant(pad) - min_b_ + Eigen::Vector3i::Ones();
+    size_t num_cells = static_cast<size_t>(div_b_[0]) * div_b_[1] * div_b_[2];
+
+    // the occupied voxels of the model, one per voxel grid centroid
+    PointCloud centroids = grid_.getFilteredPointCloud();
+    std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> > sources(
+        centroids.points.size());
+    for (size_t v = 0; v < centroids.points.size(); ++v)
+        sources[v] = grid_.getGridCoordinates(centroids.points[v].x, centroids.points[v].y,
+                                              centroids.points[v].z);
+
+    // one shared grid: a thread marks the cells seen from one model voxel in a window of the
+    // maximum range around it, and adds every marked cell once, atomically. The memory of a
+    // thread is bounded by the range rather than by the grid, whatever the padding
+    counts_.assign(num_cells, 0);
+    int range = static_cast<int>(ceil(max_range_ / leaf_size_)) + 1;
+    Eigen::Vector3i window_div = div_b_.cwiseMin(Eigen::Vector3i::Constant(2 * range + 1));
+    int num_sources = static_cast<int>(sources.size());
+#pragma omp parallel
+    {
+        std::vector<bool> visited(
+            static_cast<size_t>(window_div[0]) * window_div[1] * window_div[2], false);
+        std::vector<size_t> cells;
+#pragma omp for schedule(dynamic, 16)
+        for (int v = 0; v < num_sources; ++v)
+        {
+            Eigen::Vector3i window_min = (sources[v] - Eigen::Vector3i::Constant(range))
+                                             .cwiseMax(min_b_)
+                                             .cwiseMin(min_b_ + div_b_ - window_div);
+            cells.clear();
+            for (int i = 0; i < num_directions_; ++i)
+                castRay(sources[v], directions_[i], window_min, window_div, visited, cells);
+            for (size_t c = 0; c < cells.size(); ++c)
+            {
+                Eigen::Vector3i d = cellCoordinates(cells[c]) - window_min;
+                visited[(static_cast<size_t>(d[2]) * window_div[1] + d[1]) * window_div[0] +
+                        d[0]] = false;
+#pragma omp atomic
+                counts_[cells[c]]++;
+            }
+        }
+    }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VisibilityHeatmapT<PointInT>::castRay(const Eigen::Vector3i& source,
+                                                const Eigen::Vector4f& direction,
+                                                const Eigen::Vector3i& window_min,
+                                                const Eigen::Vector3i& window_div,
+                                                std::vector<bool>& visited,
+                                                std::vector<size_t>& cells)
+{
+    // the ray starts at the center of the source voxel
+    Eigen::Vector3i ijk = source;
+    int step[3];
+    float t_max[3], t_delta[3];
+    for (int d = 0; d < 3; ++d)
+    {
+        step[d] = (direction[d] >= 0) ? 1 : -1;
+        t_delta[d] = leaf_size_ / static_cast<float>(fabs(direction[d]));
+        t_max[d] = 0.5f * t_delta[d];
+    }
+
+    while (true)
+    {
+        // move to the next cell along the ray
+        int axis = (t_max[0] <= t_max[1] && t_max[0] <= t_max[2]) ? 0
+                                                                   : (t_max[1] <= t_max[2] ? 1 : 2);
+        if (t_max[axis] > max_range_)
+            return;
+        ijk[axis] += step[axis];
+        t_max[axis] += t_delta[axis];
+
+        Eigen::Vector3i d = ijk - min_b_;
+        if (d[0] < 0 || d[1] < 0 || d[2] < 0 || d[0] >= div_b_[0] || d[1] >= div_b_[1] ||
+            d[2] >= div_b_[2])
+            return;
+
+        // occupied voxels next to the source belong to the same surface and do not block it,
+        // the leaf layout is only looked up inside the model grid as it would alias outside
+        if ((ijk.array() >= model_min_b_.array()).all() &&
+            (ijk.array() <= model_max_b_.array()).all() && grid_.getCentroidIndexAt(ijk) != -1)
+        {
+            if ((ijk - source).squaredNorm() > 8)
+                return;
+            continue;
+        }
+
+        // every cell is counted once per model voxel, however many of its rays pass it
+        Eigen::Vector3i w = ijk - window_min;
+        size_t mark = (static_cast<size_t>(w[2]) * window_div[1] + w[1]) * window_div[0] + w[0];
+        if (!visited[mark])
+        {
+            visited[mark] = true;
+            cells.push_back((static_cast<size_t>(d[2]) * div_b_[1] + d[1]) * div_b_[0] + d[0]);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VisibilityHeatmapT<PointInT>::getHeatmap(pcl::PointCloud<pcl::PointXYZI>& cloud)
+{
+    cloud.points.clear();
+    for (int k = 0; k < div_b_[2]; ++k)
+        for (int j = 0; j < div_b_[1]; ++j)
+            for (int i = 0; i < div_b_[0]; ++i)
+            {
+                unsigned int count = counts_[(k * div_b_[1] + j) * div_b_[0] + i];
+                if (count == 0)
+                    continue;
+                pcl::PointXYZI point;
+                point.x = (min_b_[0] + i + 0.5f) * leaf_size_;
+                point.y = (min_b_[1] + j + 0.5f) * leaf_size_;
+                point.z = (min_b_[2] + k + 0.5f) * leaf_size_;
+                point.intensity = static_cast<float>(count);
+                cloud.points.push_back(point);
+            }
+    cloud.width = static_cast<uint32_t>(cloud.points.size());
+    cloud.height = 1;
+}
+
+#endif
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef VISIBLE_SURFACE_BATCH_H_
+#define VISIBLE_SURFACE_BATCH_H_
+
+#include <culling/view_statistics.h>
+#include <cstddef>
+#include <vector>
+
+namespace pcl
+{
+/** \brief The visible surface of a batch of viewpoints, as returned by
+    * OcclusionCulling::extractVisibleSurfaceBatch (). Every view is given by the indices of its
+    * points in the model, so a batch of thousands of views does not copy any point.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::VisibleSurfaceBatch batch = occlusionCulling.extractVisibleSurfaceBatch (poses);
+    * pcl::copyPointCloud (*occlusionCulling.cloud, batch.visibleIndices[v], visibleCloud);
+    * double rate = batch.getViewpointsPerSecond ();
+    * \endcode
+    *
+    * \ingroup filters
+    */
+struct VisibleSurfaceBatch
+{
+    /** \brief Model indices of the visible points of every view. */
+    std::vector<std::vector<int> > visibleIndices;
+    /** \brief Model indices of the frustum points of every view. */
+    std::vector<std::vector<int> > frustumIndices;
+    /** \brief Depth, accuracy and entropy statistics of every view. */
+    std::vector<ViewStatistics> viewStatistics;
+    /** \brief Seconds taken by every view. */
+    std::vector<double> latencies;
+    /** \brief Heap allocations of every view, counted on the thread that ran it when the
+        * allocation hooks are installed.
+        */
+    std::vector<size_t> allocations;
+    /** \brief Rays in flight during the traversal of every view. */
+    std::vector<double> rayParallelism;
+    /** \brief Number of threads the views were spread over. */
+    int threads;
+    /** \brief Wall clock seconds of the whole batch. */
+    double seconds;
+
+    VisibleSurfaceBatch() : threads(0), seconds(0)
+    {
+    }
+
+    /** \brief Returns the number of views in the batch. */
+    inline size_t size() const
+    {
+        return (visibleIndices.size());
+    }
+
+    /** \brief Returns the throughput of the batch, 0 for an empty one. */
+    inline double getViewpointsPerSecond() const
+    {
+        return (seconds > 0 ? static_cast<double>(size()) / seconds : 0);
+    }
+};
+}  // namespace pcl
+
+#endif
@@ -36,9 +36,14 @@
  * $Id$
  *
  */
+#ifndef VOXEL_GRID_H_
+#define VOXEL_GRID_H_
 
+#include <culling/voxelization_engine.h>
 #include <pcl/filters/boost.h>
 #include <pcl/filters/filter.h>
+#include <boost/static_assert.hpp>
+#include <cstdlib>
 #include <map>
 #include <vector>
 namespace pcl
@@ -66,6 +71,31 @@ void getMinMax3D(const typename pcl::PointCloud<PointInT>::ConstPtr &cloud,
                  float min_distance, float max_distance, Eigen::Vector4f &min_pt,
                  Eigen::Vector4f &max_pt, bool limit_negative = false);
 
+/** \brief Compile-time neighbourhood of a voxel for the stencil queries of VoxelGridT: the 6
+    * face, the 18 face and edge, or the 26 face, edge and corner neighbours. The neighbours are
+    * the cells of the 3x3x3 block around the voxel within an L1 distance of 1, 2 or 3.
+    * \ingroup filters
+    */
+template <int Connectivity>
+struct VoxelStencil
+{
+    // a voxel stencil has 6, 18 or 26 neighbours
+    BOOST_STATIC_ASSERT(Connectivity == 6 || Connectivity == 18 || Connectivity == 26);
+
+    /** \brief The number of neighbours. */
+    static const int size = Connectivity;
+
+    /** \brief The largest |dx| + |dy| + |dz| of a neighbour. */
+    static const int max_distance = (Connectivity == 6) ? 1 : ((Connectivity == 18) ? 2 : 3);
+
+    /** \brief Returns true if the offset (dx,dy,dz) is a neighbour of the stencil. */
+    static inline bool contains(int dx, int dy, int dz)
+    {
+        int distance = abs(dx) + abs(dy) + abs(dz);
+        return (distance != 0 && distance <= max_distance);
+    }
+};
+
 /** \brief VoxelGrid assembles a local 3D grid over a given PointCloud, and downsamples + filters the data.
     *
     * The VoxelGrid class creates a *3D voxel grid* (think about a voxel
@@ -95,8 +125,8 @@ class VoxelGridT : public Filter<PointInT>
 
   public:
     //new variables
-    std::vector<std::vector<std::vector<std::vector<PointInT> > > >
-        voxelSet;  //include the set of points of the voxel
+    std::vector<int> voxelOffsets;  //first entry of every occupied voxel in voxelPoints, plus the end
+    std::vector<int> voxelPoints;   //input cloud indices of the points, grouped by voxel
     Eigen::Vector4f minbb;
     Eigen::Vector4f maxbb;
 
@@ -107,7 +137,8 @@ class VoxelGridT : public Filter<PointInT>
         , downsample_all_data_(true)
         , save_leaf_layout_(false)
         , leaf_layout_()
-        , voxelSet()
+        , voxelOffsets()
+        , voxelPoints()
         , min_b_(Eigen::Vector4i::Zero())
         , max_b_(Eigen::Vector4i::Zero())
         , div_b_(Eigen::Vector4i::Zero())
@@ -271,6 +302,68 @@ class VoxelGridT : public Filter<PointInT>
         return (neighbors);
     }
 
+    /** \brief Visits the neighbours of a voxel given by a compile-time stencil without allocating.
+        * The callback is called as callback (offset, index) for every neighbour, in the order
+        * of z, y and x of the offset, with the index in the downsampled cloud of the neighbour
+        * (-1 if the cell is empty or out of bounds). Voxels at least one cell inside the grid
+        * take a path without bounds checks.
+        * \param[in] ijk the coordinates (i,j,k) of the voxel (may be empty or out of bounds)
+        * \param[in] callback the function object called for every neighbour
+        * \note for efficiency, user must make sure that the saving of the leaf layout is enabled and filtering performed
+        */
+    template <int Connectivity, typename Callback>
+    inline void forEachNeighborCentroidIndex(const Eigen::Vector3i &ijk, Callback callback)
+    {
+        typedef VoxelStencil<Connectivity> Stencil;
+        Eigen::Vector3i offset;
+        if ((ijk.array() > min_b_.head<3>().array()).all() &&
+            (ijk.array() < max_b_.head<3>().array()).all())
+        {
+            // interior voxel: every neighbour is inside the leaf layout
+            const int *layout = &leaf_layout_[(ijk - min_b_.head<3>()).dot(divb_mul_.head<3>())];
+            for (int dz = -1; dz <= 1; ++dz)
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dx = -1; dx <= 1; ++dx)
+                    {
+                        if (!Stencil::contains(dx, dy, dz))
+                            continue;
+                        offset << dx, dy, dz;
+                        callback(offset, layout[dx + dy * divb_mul_[1] + dz * divb_mul_[2]]);
+                    }
+            return;
+        }
+
+        for (int dz = -1; dz <= 1; ++dz)
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    if (!Stencil::contains(dx, dy, dz))
+                        continue;
+                    offset << dx, dy, dz;
+                    Eigen::Vector3i neighbor = ijk + offset;
+                    // checking if the specified cell is in the grid
+                    if ((neighbor.array() >= min_b_.head<3>().array()).all() &&
+                        (neighbor.array() <= max_b_.head<3>().array()).all())
+                        callback(offset, leaf_layout_[(neighbor - min_b_.head<3>())
+                                                          .dot(divb_mul_.head<3>())]);
+                    else
+                        callback(offset, -1);  // cell is out of bounds, consider it empty
+                }
+    }
+
+    /** \brief Visits the neighbours of the voxel of a point given by a compile-time stencil, see
+        * forEachNeighborCentroidIndex (ijk, callback).
+        * \param[in] reference_point the coordinates of the reference point (corresponding cell is allowed to be empty/out of bounds)
+        * \param[in] callback the function object called for every neighbour
+        */
+    template <int Connectivity, typename Callback>
+    inline void forEachNeighborCentroidIndex(const PointInT &reference_point, Callback callback)
+    {
+        forEachNeighborCentroidIndex<Connectivity>(
+            getGridCoordinates(reference_point.x, reference_point.y, reference_point.z),
+            callback);
+    }
+
     /** \brief Returns the layout of the leafs for fast access to cells relative to current position.
         * \note position at (i-min_x) + (j-min_y)*div_x + (k-min_z)*div_x*div_y holds the index of the element at coordinates (i,j,k) in the grid (-1 if empty)
         */
@@ -327,6 +420,31 @@ class VoxelGridT : public Filter<PointInT>
         return (leaf_layout_[idx]);
     }
 
+    /** \brief Returns the number of input points in an occupied voxel.
+        * \param[in] voxel the index of the voxel in the downsampled cloud
+        */
+    inline int getVoxelSize(int voxel)
+    {
+        return (voxelOffsets[voxel + 1] - voxelOffsets[voxel]);
+    }
+
+    /** \brief Returns the input cloud indices of the points in an occupied voxel, they are stored
+        * contiguously up to getVoxelPointsEnd ().
+        * \param[in] voxel the index of the voxel in the downsampled cloud
+        */
+    inline const int *getVoxelPointsBegin(int voxel)
+    {
+        return (&voxelPoints[0] + voxelOffsets[voxel]);
+    }
+
+    /** \brief Returns one past the last input cloud index of the points in an occupied voxel.
+        * \param[in] voxel the index of the voxel in the downsampled cloud
+        */
+    inline const int *getVoxelPointsEnd(int voxel)
+    {
+        return (&voxelPoints[0] + voxelOffsets[voxel + 1]);
+    }
+
     /** \brief Provide the name of the field to be used for filtering data. In conjunction with  \a setFilterLimits,
         * points having values outside this interval will be discarded.
         * \param[in] field_name the name of the field that contains values used for filtering
@@ -418,6 +536,12 @@ class VoxelGridT : public Filter<PointInT>
     /** \brief Set to true if we want to return the data outside (\a filter_limit_min_;\a filter_limit_max_). Default: false. */
     bool filter_limit_negative_;
 
+    /** \brief Builds the voxel grid and groups the points of every voxel. */
+    VoxelizationEngineT<PointInT> voxelization_;
+
+    /** \brief The indices of the points within the filter field limits. */
+    std::vector<int> field_indices_;
+
     typedef typename pcl::traits::fieldList<PointInT>::type FieldList;
 
     /** \brief Downsample a Point Cloud using a voxelized grid approach
@@ -426,3 +550,5 @@ class VoxelGridT : public Filter<PointInT>
     void applyFilter(PointCloud &output);
 };
 }  // namespace pcl
+#include "culling/voxel_grid.hpp"
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ * $Id$
+ *
+ */
+#ifndef VOXEL_GRID_HPP_
+#define VOXEL_GRID_HPP_
+
+#include <culling/voxel_grid.h>
+#include <pcl/common/io.h>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelGridT<PointInT>::applyFilter(PointCloud &output)
+{
+    // Has the input dataset been set already?
+    if (!input_)
+    {
+        PCL_WARN("[pcl::%s::applyFilter] No input dataset given!\n", getClassName().c_str());
+        output.width = output.height = 0;
+        output.points.clear();
+        return;
+    }
+
+    // Keep only the points within the filter field limits
+    const std::vector<int> *indices = &(*indices_);
+    if (!filter_field_name_.empty())
+    {
+        std::vector<pcl::PCLPointField> fields;
+        int distance_idx = pcl::getFieldIndex(*input_, filter_field_name_, fields);
+        if (distance_idx == -1)
+            PCL_WARN("[pcl::%s::applyFilter] Invalid filter field name. Index is %d.\n",
+                     getClassName().c_str(), distance_idx);
+        field_indices_.clear();
+        field_indices_.reserve(indices_->size());
+        for (size_t i = 0; i < indices_->size() && distance_idx != -1; ++i)
+        {
+            const uint8_t *pt_data =
+                reinterpret_cast<const uint8_t *>(&input_->points[(*indices_)[i]]);
+            float distance_value = 0;
+            memcpy(&distance_value, pt_data + fields[distance_idx].offset, sizeof(float));
+            bool inside =
+                (distance_value <= filter_limit_max_) && (distance_value >= filter_limit_min_);
+            if (inside != filter_limit_negative_)
+                field_indices_.push_back((*indices_)[i]);
+        }
+        indices = &field_indices_;
+    }
+
+    voxelization_.setInverseLeafSize(inverse_leaf_size_);
+    if (voxelization_.voxelize(*input_, *indices) == -1)
+    {
+        PCL_WARN("[pcl::%s::applyFilter] Leaf size is too small for the input dataset. Integer "
+                 "indices would overflow.",
+                 getClassName().c_str());
+        output = *input_;
+        voxelOffsets.clear();
+        voxelPoints.clear();
+        return;
+    }
+    min_b_ = voxelization_.getMinBoxCoordinates();
+    max_b_ = voxelization_.getMaxBoxCoordinates();
+    div_b_ = voxelization_.getNrDivisions();
+    divb_mul_ = voxelization_.getDivisionMultiplier();
+    minbb = min_b_.cast<float>().cwiseProduct(leaf_size_);
+    maxbb = (max_b_ + Eigen::Vector4i::Ones()).cast<float>().cwiseProduct(leaf_size_);
+
+    if (save_leaf_layout_)
+        voxelization_.computeLeafLayout(leaf_layout_);
+    voxelization_.computeCentroids(*input_, downsample_all_data_, output);
+
+    // The sorted pairs already group the points by voxel, only their indices are kept
+    const std::vector<std::pair<unsigned int, unsigned int> > &ranges =
+        voxelization_.getVoxelRanges();
+    const std::vector<std::pair<unsigned int, unsigned int> > &pairs =
+        voxelization_.getSortedIndices();
+    int num_voxels = static_cast<int>(ranges.size());
+    voxelOffsets.resize(num_voxels + 1);
+    voxelOffsets[0] = 0;
+    for (int v = 0; v < num_voxels; ++v)
+        voxelOffsets[v + 1] = voxelOffsets[v] + (ranges[v].second - ranges[v].first);
+    voxelPoints.resize(voxelOffsets[num_voxels]);
+#pragma omp parallel for
+    for (int v = 0; v < num_voxels; ++v)
+    {
+        int *points = &voxelPoints[0] + voxelOffsets[v];
+        for (unsigned int li = ranges[v].first; li < ranges[v].second; ++li)
+            *points++ = static_cast<int>(pairs[li].second);
+    }
+}
+
+#endif
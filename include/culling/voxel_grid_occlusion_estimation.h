@@ -40,6 +40,7 @@
 #ifndef VOXEL_GRID_OCCLUSION_ESTIMATION_H_
 #define VOXEL_GRID_OCCLUSION_ESTIMATION_H_
 
+#include <culling/voxelization_engine.h>
 #include <pcl/filters/voxel_grid.h>
 
 namespace pcl
@@ -58,8 +59,17 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
     using VoxelGrid<PointInT>::min_b_;
     using VoxelGrid<PointInT>::max_b_;
     using VoxelGrid<PointInT>::div_b_;
+    using VoxelGrid<PointInT>::divb_mul_;
+    using VoxelGrid<PointInT>::leaf_layout_;
     using VoxelGrid<PointInT>::leaf_size_;
     using VoxelGrid<PointInT>::inverse_leaf_size_;
+    using VoxelGrid<PointInT>::input_;
+    using VoxelGrid<PointInT>::indices_;
+    using PCLBase<PointInT>::fake_indices_;
+    using VoxelGrid<PointInT>::downsample_all_data_;
+    using VoxelGrid<PointInT>::save_leaf_layout_;
+    using VoxelGrid<PointInT>::filter_field_name_;
+    using VoxelGrid<PointInT>::min_points_per_voxel_;
 
     typedef typename Filter<PointInT>::PointCloud PointCloud;
     typedef typename PointCloud::Ptr PointCloudPtr;
@@ -68,6 +78,12 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
   public:
     /** \brief Empty constructor. */
     VoxelGridOcclusionEstimationT()
+        : traverse_from_sensor_(false),
+          sort_rays_(false),
+          ray_steps_(0),
+          ray_rounds_(0),
+          max_accuracy_error_(0),
+          entropy_total_(0)
     {
         initialized_ = false;
         this->setSaveLeafLayout(true);
@@ -84,6 +100,39 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
         */
     void initializeVoxelGrid();
 
+    /** \brief Initialize the voxel grid from the (i, j, k) coordinates of its occupied voxels
+        * instead of from the input cloud. The bounds and the occupancy are the ones
+        * initializeVoxelGrid () computes for the points of those voxels, but no centroids are
+        * computed, and leaf layout entries hold the position in occupied_voxels.
+        * \param[in] occupied_voxels the distinct occupied voxels, at least one
+        */
+    void initializeVoxelGrid(
+        const std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >&
+            occupied_voxels);
+
+    /** \brief Returns, for every input point of the last occlusionFreeEstimationAll () call,
+        * whether it is free (1) or occluded (0).
+        */
+    inline const std::vector<char>& getFreeStates() const
+    {
+        return (free_states_);
+    }
+
+    /** \brief Returns true once initializeVoxelGrid () was called. */
+    inline bool isInitialized()
+    {
+        return (initialized_);
+    }
+
+    /** \brief Allocates the buffers of the grid and of the occlusion estimation, so that
+        * initializing the grid from no more points and estimating the occlusion of no more
+        * targets does not allocate.
+        * \param[in] num_points the largest number of input points and targets
+        * \param[in] num_cells the largest number of cells of the grid
+        * \param[in] ray_group_size the largest number of rays in flight
+        */
+    void reserve(size_t num_points, size_t num_cells, int ray_group_size);
+
     /** \brief Returns the state (free = 0, occluded = 1) of the voxel
         * after utilizing a ray traversal algorithm to a target voxel
         * in (i, j, k) coordinates.
@@ -108,6 +157,99 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
         std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >& out_ray,
         const Eigen::Vector3i& in_target_voxel);
 
+    /** \brief Returns the state (free = 0, occluded = 1, no intersection = -1) of a batch of
+        * target voxels. Up to \a ray_group_size independent rays are advanced round-robin,
+        * one voxel at a time, and the leaf layout entry of each ray's next voxel is
+        * prefetched before switching to the next ray so the memory accesses overlap.
+        * \param[out] out_states The state of each target voxel.
+        * \param[in] in_target_voxels The target voxel coordinates (i, j, k).
+        * \param[in] ray_group_size The number of rays in flight (1 traverses rays one by one).
+        * \return 0 on success, -1 if the voxel grid was not initialized
+        */
+    int occlusionEstimation(
+        std::vector<int>& out_states,
+        const std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >&
+            in_target_voxels,
+        int ray_group_size);
+
+    /** \brief Returns the state (free = 0, occluded = 1) of the line of sight leaving a voxel
+        * in a given direction: occluded if it hits an occupied voxel before it leaves the voxel
+        * grid or exceeds the maximum range.
+        * \param[out] out_state The state of the line of sight.
+        * \param[out] out_distance The distance at which the ray enters the occupied voxel
+        * (max_range if the line of sight is free).
+        * \param[in] in_source_voxel The voxel coordinate (i, j, k) the ray starts from.
+        * \param[in] in_direction The normalized direction of the ray.
+        * \param[in] max_range The distance up to which the ray is traversed.
+        * \return 0 on success, -1 if the voxel grid was not initialized
+        */
+    int lineOfSightEstimation(int& out_state, float& out_distance,
+                              const Eigen::Vector3i& in_source_voxel,
+                              const Eigen::Vector4f& in_direction, float max_range);
+
+    /** \brief Set to true to start the ray traversal at the sensor voxel when the sensor origin
+        * lies inside the bounding box of the voxel grid. Otherwise the rays start where their
+        * line enters the bounding box, which is behind the sensor in that case.
+        * \param[in] traverse_from_sensor the new value (true/false)
+        */
+    inline void setTraverseFromSensor(bool traverse_from_sensor)
+    {
+        traverse_from_sensor_ = traverse_from_sensor;
+    }
+
+    /** \brief Returns true if rays start at a sensor that lies inside the voxel grid. */
+    inline bool getTraverseFromSensor()
+    {
+        return (traverse_from_sensor_);
+    }
+
+    /** \brief Returns the scaling value (tmin) where the traversal of a ray starts
+        * (p_start = origin + tmin * direction): 0 if the traversal starts at an origin inside
+        * the voxel grid, otherwise the entry point into the bounding box (-1 if there is none).
+        * \param[in] origin The sensor origin
+        * \param[in] direction The sensor orientation
+        * \return the scaling value
+        */
+    inline float getRayStart(const Eigen::Vector4f& origin, const Eigen::Vector4f& direction)
+    {
+        if (traverse_from_sensor_ && isInsideBoundingBox(origin))
+            return 0.0f;
+        return rayBoxIntersection(origin, direction);
+    }
+
+    /** \brief Returns true if the point lies strictly inside the bounding box of the voxel grid.
+        * \param[in] point The point coordinate (x,y,z)
+        */
+    inline bool isInsideBoundingBox(const Eigen::Vector4f& point)
+    {
+        return (point[0] > b_min_[0] && point[0] < b_max_[0] && point[1] > b_min_[1] &&
+                point[1] < b_max_[1] && point[2] > b_min_[2] && point[2] < b_max_[2]);
+    }
+
+    /** \brief Set to true to traverse the rays of a batch in order of their direction from the
+        * sensor instead of the order of the targets, so that consecutive rays visit neighbouring
+        * voxels. The states are still returned in the order of the targets.
+        * \param[in] sort_rays the new value (true/false)
+        */
+    inline void setSortRaysByDirection(bool sort_rays)
+    {
+        sort_rays_ = sort_rays;
+    }
+
+    /** \brief Returns true if the rays of a batch are traversed in order of their direction. */
+    inline bool getSortRaysByDirection()
+    {
+        return (sort_rays_);
+    }
+
+    /** \brief Returns the average number of rays in flight per round of the last batch
+        * occlusion estimation, i.e. the achieved memory-level parallelism.
+        */
+    inline double getMemoryLevelParallelism()
+    {
+        return (ray_rounds_ > 0 ? static_cast<double>(ray_steps_) / ray_rounds_ : 0.0);
+    }
+
     /** \brief Returns the voxel coordinates (i, j, k) of all occluded
         * voxels in the voxel gird.
         * \param[out] occluded_voxels the coordinates (i, j, k) of all occluded voxels
@@ -116,6 +258,38 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
     int occlusionEstimationAll(
         std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >& occluded_voxels);
 
+    /** \brief Returns the points of a cloud that are not occluded from the sensor origin and
+        * the entropy of each of them, with the per point visibility and entropy of the
+        * rayTraversalGPU kernel of VoxelGridOcclusionEstimationGPU::occlusionFreeEstimationAll.
+        * A point is occluded if the ray to the centroid of its voxel crosses an occupied voxel
+        * more than two voxels away from it, and has no result if the ray misses the grid. The
+        * entropy is the binary entropy of the depth accuracy normalised by the largest error
+        * of the voxel grid, both measured along z as in the kernel, so it is not a number for
+        * points level with the sensor or beyond that error.
+        * The ray setup is vectorized over blocks of points and the blocks are traversed in
+        * parallel.
+        * \param[in] in_cloud the points, usually the input cloud of the voxel grid
+        * \param[out] out_free_points the points that are not occluded, in the order of in_cloud
+        * \param[out] out_entropies the entropy of each point of out_free_points
+        * \return 0 on success, -1 if the voxel grid is not initialized
+        */
+    int occlusionFreeEstimationAll(const PointCloud& in_cloud, PointCloud& out_free_points,
+                                   std::vector<float>& out_entropies);
+
+    /** \brief Returns the sum of the entropies of the last occlusionFreeEstimationAll (). */
+    inline float getEntropyTotal()
+    {
+        return (entropy_total_);
+    }
+
+    /** \brief Returns the largest depth error of the voxel grid that normalised the entropies
+        * of the last occlusionFreeEstimationAll ().
+        */
+    inline float getMaxAccuracyError()
+    {
+        return (max_accuracy_error_);
+    }
+
     /** \brief Returns the voxel grid filtered point cloud
         * \return The voxel grid filtered point cloud
         */
@@ -160,8 +334,14 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
         return xyz;
     }
 
-    // inline void
-    // setSensorOrigin (const Eigen::Vector4f origin) { sensor_origin_ = origin; }
+    /** \brief Set the sensor origin the rays are traversed from, overriding the origin of the
+        * input cloud after the voxel grid was initialized.
+        * \param[in] origin The sensor origin
+        */
+    inline void setSensorOrigin(const Eigen::Vector4f& origin)
+    {
+        sensor_origin_ = origin;
+    }
 
     // inline void
     // setSensorOrientation (const Eigen::Quaternionf orientation) { sensor_orientation_ = orientation; }
@@ -170,6 +350,56 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
                              PointInT& minPoint, PointInT& maxPoint);
 
   protected:
+    /** \brief Builds the voxel grid of the input cloud with the parallel voxelization engine.
+        * The output, bounds and leaf layout are those of VoxelGrid::applyFilter; filtering on a
+        * field is left to it.
+        * \param[out] output the centroid of every occupied voxel
+        */
+    virtual void applyFilter(PointCloud& output);
+
+    /** \brief Traversal state of a single ray, so that several rays can be advanced in turn. */
+    struct RayState
+    {
+        int ijk[3];
+        int target[3];
+        int step[3];
+        float t_max[3];
+        float t_delta[3];
+        Eigen::Vector4f target_centroid;
+        size_t slot;
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    /** \brief Sets up the traversal of a ray entering the voxel grid at t_min.
+        * \param[out] ray The ray state.
+        * \param[in] target_voxel The target voxel in the voxel grid with coordinate (i, j, k).
+        * \param[in] origin The sensor origin.
+        * \param[in] direction The sensor orientation
+        * \param[in] t_min The scaling value (tmin).
+        */
+    void initializeRay(RayState& ray, const Eigen::Vector3i& target_voxel,
+                       const Eigen::Vector4f& origin, const Eigen::Vector4f& direction,
+                       const float t_min);
+
+    /** \brief Visits the current voxel of the ray and moves it to the next one.
+        * \param[in,out] ray The ray state.
+        * \return -1 if the ray continues, otherwise the state of the target voxel (0 = visible, 1 = occupied)
+        */
+    int advanceRay(RayState& ray);
+
+    /** \brief Prefetches the leaf layout entry of the voxel the ray visits next.
+        * \param[in] ray The ray state.
+        */
+    inline void prefetchRay(const RayState& ray)
+    {
+#if defined(__GNUC__)
+        int idx = (ray.ijk[0] - min_b_[0]) * divb_mul_[0] + (ray.ijk[1] - min_b_[1]) * divb_mul_[1] +
+                  (ray.ijk[2] - min_b_[2]) * divb_mul_[2];
+        if (idx >= 0 && idx < static_cast<int>(leaf_layout_.size()))
+            __builtin_prefetch(&leaf_layout_[idx]);
+#endif
+    }
+
     /** \brief Returns the scaling value (tmin) were the ray intersects with the
         * voxel grid bounding box. (p_entry = origin + tmin * orientation)
         * \param[in] origin The sensor origin
@@ -203,6 +433,40 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
         const Eigen::Vector3i& target_voxel, const Eigen::Vector4f& origin,
         const Eigen::Vector4f& direction, const float t_min);
 
+    /** \brief Returns a key that orders unit directions along a space filling curve: the
+        * direction is mapped onto the octahedron, quantized to 16 bits per axis and the two
+        * coordinates are interleaved (Morton code).
+        * \param[in] direction The normalized direction.
+        * \return the direction key
+        */
+    inline unsigned int getDirectionKey(const Eigen::Vector4f& direction)
+    {
+        float norm = fabs(direction[0]) + fabs(direction[1]) + fabs(direction[2]);
+        float u = direction[0] / norm;
+        float v = direction[1] / norm;
+        if (direction[2] < 0)
+        {
+            float fu = (1.0f - fabs(v)) * (u >= 0 ? 1.0f : -1.0f);
+            float fv = (1.0f - fabs(u)) * (v >= 0 ? 1.0f : -1.0f);
+            u = fu;
+            v = fv;
+        }
+        unsigned int qu = static_cast<unsigned int>((u * 0.5f + 0.5f) * 65535.0f);
+        unsigned int qv = static_cast<unsigned int>((v * 0.5f + 0.5f) * 65535.0f);
+        return (spreadBits(qu) | (spreadBits(qv) << 1));
+    }
+
+    /** \brief Spreads the lower 16 bits of a value to the even bits of the result. */
+    inline unsigned int spreadBits(unsigned int x)
+    {
+        x &= 0x0000ffff;
+        x = (x | (x << 8)) & 0x00ff00ff;
+        x = (x | (x << 4)) & 0x0f0f0f0f;
+        x = (x | (x << 2)) & 0x33333333;
+        x = (x | (x << 1)) & 0x55555555;
+        return x;
+    }
+
     /** \brief Returns a rounded value. 
         * \param[in] d
         * \return rounded value
@@ -212,6 +476,19 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
         return static_cast<float>(floor(d + 0.5f));
     }
 
+    /** \brief Returns the (i,j,k) coordinates of the voxel where the traversal of a ray starts.
+        * A ray entering the grid starts on a voxel boundary and is rounded, a ray starting
+        * at a sensor inside the grid starts inside the voxel that contains the sensor.
+        * \param[in] start The start point of the ray
+        * \param[in] t_min The scaling value (tmin) of the start point
+        */
+    inline Eigen::Vector3i getRayStartVoxel(const Eigen::Vector4f& start, const float t_min)
+    {
+        if (t_min == 0.0f && isInsideBoundingBox(start))
+            return (this->getGridCoordinates(start[0], start[1], start[2]));
+        return getGridCoordinatesRound(start[0], start[1], start[2]);
+    }
+
     // We use round here instead of floor due to some numerical issues.
     /** \brief Returns the corresponding (i,j,k) coordinates in the grid of point (x,y,z).
         * \param[in] x the X point coordinate to get the (i, j, k) index at
@@ -225,6 +502,14 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
                                static_cast<int>(round(z * inverse_leaf_size_[2])));
     }
 
+    /** \brief Estimates the state and entropy of the points [begin, begin + n) of the input of
+        * occlusionFreeEstimationAll (), n being at most free_block_size_.
+        */
+    void estimateFreeBlock(const PointCloud& in_cloud, int begin, int n);
+
+    // number of rays of occlusionFreeEstimationAll () set up together
+    static const int free_block_size_ = 64;
+
     // initialization flag
     bool initialized_;
 
@@ -236,6 +521,31 @@ class VoxelGridOcclusionEstimationT : public VoxelGrid<PointInT>
 
     // voxel grid filtered cloud
     PointCloud filtered_cloud_;
+
+    // builds the voxel grid, keeps its buffers between filter calls
+    VoxelizationEngineT<PointInT> voxelization_;
+
+    // start the rays at a sensor that lies inside the voxel grid
+    bool traverse_from_sensor_;
+
+    // traverse the rays of a batch in order of their direction
+    bool sort_rays_;
+
+    // direction key and target index of the rays of the last batch, in traversal order
+    std::vector<std::pair<unsigned int, size_t> > ray_order_;
+
+    // slots of the rays in flight, kept across batches
+    std::vector<RayState, Eigen::aligned_allocator<RayState> > ray_states_;
+
+    // voxels visited and traversal rounds of the last batch occlusion estimation
+    size_t ray_steps_, ray_rounds_;
+
+    // entropy normalisation and total entropy of the last occlusion free estimation
+    float max_accuracy_error_, entropy_total_;
+
+    // state (free = 1) and entropy of every point of the last occlusion free estimation
+    std::vector<char> free_states_;
+    std::vector<float> free_entropies_;
 };
 }  // namespace pcl
 #include "culling/voxel_grid_occlusion_estimation.hpp"
@@ -41,8 +41,11 @@
 #ifndef VOXEL_GRID_OCCLUSION_ESTIMATION_HPP_
 #define VOXEL_GRID_OCCLUSION_ESTIMATION_HPP_
 
+#include <culling/parallel_threads.h>
 #include <culling/voxel_grid_occlusion_estimation.h>
 #include <pcl/common/common.h>
+#include <algorithm>
+#include <cmath>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT>
@@ -67,6 +70,109 @@ void pcl::VoxelGridOcclusionEstimationT<PointInT>::initializeVoxelGrid()
     sensor_orientation_ = filtered_cloud_.sensor_orientation_;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelGridOcclusionEstimationT<PointInT>::initializeVoxelGrid(
+    const std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >& occupied_voxels)
+{
+    initialized_ = true;
+    filtered_cloud_.points.clear();
+    filtered_cloud_.width = filtered_cloud_.height = 0;
+
+    // the box of the voxels is the box of their points, floor () being monotonic
+    Eigen::Vector3i min_voxel = occupied_voxels[0];
+    Eigen::Vector3i max_voxel = occupied_voxels[0];
+    for (size_t i = 1; i < occupied_voxels.size(); ++i)
+    {
+        min_voxel = min_voxel.cwiseMin(occupied_voxels[i]);
+        max_voxel = max_voxel.cwiseMax(occupied_voxels[i]);
+    }
+    min_b_ = Eigen::Vector4i(min_voxel[0], min_voxel[1], min_voxel[2], 0);
+    max_b_ = Eigen::Vector4i(max_voxel[0], max_voxel[1], max_voxel[2], 0);
+    div_b_ = max_b_ - min_b_ + Eigen::Vector4i::Ones();
+    div_b_[3] = 0;
+    divb_mul_ = Eigen::Vector4i(1, div_b_[0], div_b_[0] * div_b_[1], 0);
+
+    leaf_layout_.assign(static_cast<size_t>(div_b_[0]) * div_b_[1] * div_b_[2], -1);
+    for (size_t i = 0; i < occupied_voxels.size(); ++i)
+    {
+        const Eigen::Vector3i& ijk = occupied_voxels[i];
+        int idx = (ijk[0] - min_b_[0]) * divb_mul_[0] + (ijk[1] - min_b_[1]) * divb_mul_[1] +
+                  (ijk[2] - min_b_[2]) * divb_mul_[2];
+        leaf_layout_[idx] = static_cast<int>(i);
+    }
+
+    b_min_[0] = (static_cast<float>(min_b_[0]) * leaf_size_[0]);
+    b_min_[1] = (static_cast<float>(min_b_[1]) * leaf_size_[1]);
+    b_min_[2] = (static_cast<float>(min_b_[2]) * leaf_size_[2]);
+    b_max_[0] = (static_cast<float>((max_b_[0]) + 1) * leaf_size_[0]);
+    b_max_[1] = (static_cast<float>((max_b_[1]) + 1) * leaf_size_[1]);
+    b_max_[2] = (static_cast<float>((max_b_[2]) + 1) * leaf_size_[2]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelGridOcclusionEstimationT<PointInT>::reserve(size_t num_points, size_t num_cells,
+                                                           int ray_group_size)
+{
+    // without indices the filter indexes every input point, the list only grows with the input
+    if (!indices_)
+    {
+        indices_.reset(new std::vector<int>);
+        fake_indices_ = true;
+    }
+    if (fake_indices_)
+        indices_->reserve(num_points);
+    voxelization_.reserve(num_points);
+    leaf_layout_.reserve(num_cells);
+    filtered_cloud_.points.reserve(num_points);
+    ray_order_.reserve(num_points);
+    ray_states_.reserve(std::max(ray_group_size, 1));
+    free_states_.reserve(num_points);
+    free_entropies_.reserve(num_points);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelGridOcclusionEstimationT<PointInT>::applyFilter(PointCloud& output)
+{
+#if PCL_VERSION_COMPARE(<, 1, 8, 0)
+    VoxelGrid<PointInT>::applyFilter(output);
+#else
+    if (!filter_field_name_.empty())
+    {
+        VoxelGrid<PointInT>::applyFilter(output);
+        return;
+    }
+    if (!input_)
+    {
+        PCL_WARN("[pcl::%s::applyFilter] No input dataset given!\n", this->getClassName().c_str());
+        output.width = output.height = 0;
+        output.points.clear();
+        return;
+    }
+
+    voxelization_.setInverseLeafSize(inverse_leaf_size_);
+    voxelization_.setMinPointsPerVoxel(min_points_per_voxel_);
+    if (voxelization_.voxelize(*input_, *indices_) == -1)
+    {
+        PCL_WARN("[pcl::%s::applyFilter] Leaf size is too small for the input dataset. Integer "
+                 "indices would overflow.",
+                 this->getClassName().c_str());
+        output = *input_;
+        return;
+    }
+    min_b_ = voxelization_.getMinBoxCoordinates();
+    max_b_ = voxelization_.getMaxBoxCoordinates();
+    div_b_ = voxelization_.getNrDivisions();
+    divb_mul_ = voxelization_.getDivisionMultiplier();
+
+    if (save_leaf_layout_)
+        voxelization_.computeLeafLayout(leaf_layout_);
+    voxelization_.computeCentroids(*input_, downsample_all_data_, output);
+#endif
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT>
 int pcl::VoxelGridOcclusionEstimationT<PointInT>::occlusionEstimation(
@@ -84,7 +190,7 @@ int pcl::VoxelGridOcclusionEstimationT<PointInT>::occlusionEstimation(
     direction.normalize();
 
     // estimate entry point into the voxel grid
-    float tmin = rayBoxIntersection(sensor_origin_, direction);
+    float tmin = getRayStart(sensor_origin_, direction);
 
     if (tmin == -1)
     {
@@ -117,7 +223,7 @@ int pcl::VoxelGridOcclusionEstimationT<PointInT>::occlusionEstimation(
     direction.normalize();
 
     // estimate entry point into the voxel grid
-    float tmin = rayBoxIntersection(sensor_origin_, direction);
+    float tmin = getRayStart(sensor_origin_, direction);
 
     if (tmin == -1)
     {
@@ -131,6 +237,140 @@ int pcl::VoxelGridOcclusionEstimationT<PointInT>::occlusionEstimation(
     return 0;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VoxelGridOcclusionEstimationT<PointInT>::occlusionEstimation(
+    std::vector<int>& out_states,
+    const std::vector<Eigen::Vector3i, Eigen::aligned_allocator<Eigen::Vector3i> >&
+        in_target_voxels,
+    int ray_group_size)
+{
+    if (!initialized_)
+    {
+        PCL_ERROR("Voxel grid not initialized; call initializeVoxelGrid () first! \n");
+        return -1;
+    }
+
+    out_states.assign(in_target_voxels.size(), -1);
+    ray_steps_ = 0;
+    ray_rounds_ = 0;
+    if (ray_group_size < 1)
+        ray_group_size = 1;
+
+    // order the rays by their direction from the sensor so that consecutive rays
+    // traverse neighbouring voxels
+    ray_order_.resize(in_target_voxels.size());
+    for (size_t i = 0; i < in_target_voxels.size(); ++i)
+    {
+        unsigned int key = 0;
+        if (sort_rays_)
+        {
+            Eigen::Vector4f direction = getCentroidCoordinate(in_target_voxels[i]) - sensor_origin_;
+            direction.normalize();
+            key = getDirectionKey(direction);
+        }
+        ray_order_[i] = std::make_pair(key, i);
+    }
+    if (sort_rays_)
+        std::sort(ray_order_.begin(), ray_order_.end());
+
+    ray_states_.resize(ray_group_size);
+    RayState* rays = &ray_states_[0];
+    size_t next_target = 0;
+    int active = 0;
+    while (true)
+    {
+        // start new rays until every slot of the group is busy
+        while (active < ray_group_size && next_target < ray_order_.size())
+        {
+            size_t target = ray_order_[next_target].second;
+
+            // estimate direction to target voxel
+            Eigen::Vector4f p = getCentroidCoordinate(in_target_voxels[target]);
+            Eigen::Vector4f direction = p - sensor_origin_;
+            direction.normalize();
+
+            // estimate entry point into the voxel grid
+            float tmin = getRayStart(sensor_origin_, direction);
+            if (tmin == -1)
+            {
+                PCL_ERROR("The ray does not intersect with the bounding box \n");
+            }
+            else
+            {
+                initializeRay(rays[active], in_target_voxels[target], sensor_origin_, direction,
+                              tmin);
+                rays[active].slot = target;
+                prefetchRay(rays[active]);
+                active++;
+            }
+            next_target++;
+        }
+        if (active == 0)
+            break;
+
+        // advance every ray by one voxel, the next voxel of each ray is prefetched while
+        // the other rays of the group are processed
+        ray_steps_ += active;
+        ray_rounds_++;
+        int r = 0;
+        while (r < active)
+        {
+            int state = advanceRay(rays[r]);
+            if (state == -1)
+            {
+                prefetchRay(rays[r]);
+                r++;
+            }
+            else
+            {
+                out_states[rays[r].slot] = state;
+                rays[r] = rays[--active];
+            }
+        }
+    }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VoxelGridOcclusionEstimationT<PointInT>::lineOfSightEstimation(
+    int& out_state, float& out_distance, const Eigen::Vector3i& in_source_voxel,
+    const Eigen::Vector4f& in_direction, float max_range)
+{
+    if (!initialized_)
+    {
+        PCL_ERROR("Voxel grid not initialized; call initializeVoxelGrid () first! \n");
+        return -1;
+    }
+
+    // the ray starts at the center of the source voxel and aims at a voxel outside of the
+    // grid, so it ends when it leaves the grid, exceeds the range or hits an occupied voxel
+    Eigen::Vector4f origin = getCentroidCoordinate(in_source_voxel);
+    Eigen::Vector3i outside(max_b_[0] + 2, max_b_[1] + 2, max_b_[2] + 2);
+    RayState ray;
+    initializeRay(ray, outside, origin, in_direction, 0.0f);
+    ray.target_centroid = origin;
+
+    int state = -1;
+    float t_entry = 0.0f;
+    while (state == -1)
+    {
+        // distance at which the ray leaves the current voxel
+        float t_exit = std::min(ray.t_max[0], std::min(ray.t_max[1], ray.t_max[2]));
+        state = advanceRay(ray);
+        if (state == -1)
+        {
+            if (t_exit > max_range)
+                state = 0;
+            t_entry = t_exit;
+        }
+    }
+    out_state = state;
+    out_distance = (state == 1) ? t_entry : max_range;
+    return 0;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT>
 int pcl::VoxelGridOcclusionEstimationT<PointInT>::occlusionEstimationAll(
@@ -162,7 +402,7 @@ int pcl::VoxelGridOcclusionEstimationT<PointInT>::occlusionEstimationAll(
                     direction.normalize();
 
                     // estimate entry point into the voxel grid
-                    float tmin = rayBoxIntersection(sensor_origin_, direction);
+                    float tmin = getRayStart(sensor_origin_, direction);
 
                     // ray traversal
                     int state = rayTraversal(ijk, sensor_origin_, direction, tmin);
@@ -175,6 +415,218 @@ int pcl::VoxelGridOcclusionEstimationT<PointInT>::occlusionEstimationAll(
     return 0;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VoxelGridOcclusionEstimationT<PointInT>::occlusionFreeEstimationAll(
+    const PointCloud& in_cloud, PointCloud& out_free_points, std::vector<float>& out_entropies)
+{
+    if (!initialized_)
+    {
+        PCL_ERROR("Voxel grid not initialized; call initializeVoxelGrid () first! \n");
+        return -1;
+    }
+
+    // the largest depth error of the voxel grid normalises the entropies
+    double max_depth = 0;
+    for (size_t i = 0; i < filtered_cloud_.points.size(); ++i)
+        if (max_depth < filtered_cloud_.points[i].z)
+            max_depth = filtered_cloud_.points[i].z;
+    max_accuracy_error_ = static_cast<float>(0.0000285 * max_depth * max_depth);
+
+    int num_points = static_cast<int>(in_cloud.points.size());
+    free_states_.assign(num_points, 0);
+    free_entropies_.resize(num_points);
+
+    // a single thread estimates the blocks outside of a parallel region
+    int num_threads = getParallelThreads();
+    if (num_threads > 1)
+    {
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+        for (int begin = 0; begin < num_points; begin += free_block_size_)
+            estimateFreeBlock(in_cloud, begin, std::min(free_block_size_, num_points - begin));
+    }
+    else
+        for (int begin = 0; begin < num_points; begin += free_block_size_)
+            estimateFreeBlock(in_cloud, begin, std::min(free_block_size_, num_points - begin));
+
+    // the free points and their entropies are kept in the order of the input
+    out_free_points.points.clear();
+    out_entropies.clear();
+    entropy_total_ = 0;
+    for (int i = 0; i < num_points; ++i)
+    {
+        if (!free_states_[i])
+            continue;
+        out_free_points.points.push_back(in_cloud.points[i]);
+        out_entropies.push_back(free_entropies_[i]);
+        entropy_total_ += free_entropies_[i];
+    }
+    out_free_points.header = in_cloud.header;
+    out_free_points.width = static_cast<uint32_t>(out_free_points.points.size());
+    out_free_points.height = 1;
+    out_free_points.is_dense = in_cloud.is_dense;
+    out_free_points.sensor_orientation_ = in_cloud.sensor_orientation_;
+    out_free_points.sensor_origin_ = in_cloud.sensor_origin_;
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelGridOcclusionEstimationT<PointInT>::estimateFreeBlock(const PointCloud& in_cloud,
+                                                                    int begin, int n)
+{
+    // the arithmetic below follows the precision of the variables of the GPU kernel
+    const float max_acc = max_accuracy_error_;
+    const float inv_x = inverse_leaf_size_[0], inv_y = inverse_leaf_size_[1],
+                inv_z = inverse_leaf_size_[2];
+    const float leaf_x = leaf_size_[0], leaf_y = leaf_size_[1], leaf_z = leaf_size_[2];
+    const float b_min_x = b_min_[0], b_min_y = b_min_[1], b_min_z = b_min_[2];
+    const float b_max_x = b_max_[0], b_max_y = b_max_[1], b_max_z = b_max_[2];
+    const float origin_x = sensor_origin_[0], origin_y = sensor_origin_[1],
+                origin_z = sensor_origin_[2];
+    const int min_x = min_b_[0], min_y = min_b_[1], min_z = min_b_[2];
+    const int max_x = max_b_[0], max_y = max_b_[1], max_z = max_b_[2];
+    const int mul_x = divb_mul_[0], mul_y = divb_mul_[1], mul_z = divb_mul_[2];
+    const int layout_size = static_cast<int>(leaf_layout_.size());
+    const int block_size = free_block_size_;
+
+    double x[block_size], y[block_size], z[block_size];
+    for (int b = 0; b < n; ++b)
+    {
+        const PointInT& point = in_cloud.points[begin + b];
+        x[b] = point.x;
+        y[b] = point.y;
+        z[b] = point.z;
+    }
+
+    // target voxel, direction and entry into the grid of the rays of the block
+    int ti[block_size], tj[block_size], tk[block_size];
+    double cx[block_size], cy[block_size], cz[block_size];
+    double dx[block_size], dy[block_size], dz[block_size], depth_acc[block_size];
+    float t_entry[block_size];
+    char hit[block_size];
+#pragma omp simd
+    for (int b = 0; b < n; ++b)
+    {
+        ti[b] = static_cast<int>(floor(x[b] * inv_x));
+        tj[b] = static_cast<int>(floor(y[b] * inv_y));
+        tk[b] = static_cast<int>(floor(z[b] * inv_z));
+        cx[b] = b_min_x + (leaf_x * 0.5f) + (static_cast<float>(ti[b] - min_x) * leaf_x);
+        cy[b] = b_min_y + (leaf_y * 0.5f) + (static_cast<float>(tj[b] - min_y) * leaf_y);
+        cz[b] = b_min_z + (leaf_z * 0.5f) + (static_cast<float>(tk[b] - min_z) * leaf_z);
+
+        double direction_x = cx[b] - origin_x;
+        double direction_y = cy[b] - origin_y;
+        double direction_z = cz[b] - origin_z;
+        // the kernel takes the z distance to the voxel centroid as the depth
+        depth_acc[b] = 0.0000285 * direction_z * direction_z;
+        double length = sqrt(direction_x * direction_x + direction_y * direction_y +
+                             direction_z * direction_z);
+        dx[b] = direction_x / length;
+        dy[b] = direction_y / length;
+        dz[b] = direction_z / length;
+
+        float t_min = ((dx[b] >= 0 ? b_min_x : b_max_x) - origin_x) / dx[b];
+        float t_max = ((dx[b] >= 0 ? b_max_x : b_min_x) - origin_x) / dx[b];
+        float ty_min = ((dy[b] >= 0 ? b_min_y : b_max_y) - origin_y) / dy[b];
+        float ty_max = ((dy[b] >= 0 ? b_max_y : b_min_y) - origin_y) / dy[b];
+        bool miss = (t_min > ty_max) || (ty_min > t_max);
+        t_min = (ty_min > t_min) ? ty_min : t_min;
+        t_max = (ty_max < t_max) ? ty_max : t_max;
+        float tz_min = ((dz[b] >= 0 ? b_min_z : b_max_z) - origin_z) / dz[b];
+        float tz_max = ((dz[b] >= 0 ? b_max_z : b_min_z) - origin_z) / dz[b];
+        miss = miss || (t_min > tz_max) || (tz_min > t_max);
+        t_entry[b] = (tz_min > t_min) ? tz_min : t_min;
+        hit[b] = !miss;
+    }
+
+    for (int b = 0; b < n; ++b)
+    {
+        if (!hit[b])
+            continue;
+        float t_min = t_entry[b];
+        double start_x = origin_x + t_min * dx[b];
+        double start_y = origin_y + t_min * dy[b];
+        double start_z = origin_z + t_min * dz[b];
+
+        // voxel where the ray enters the grid
+        double i = static_cast<int>(::round(start_x * inv_x));
+        double j = static_cast<int>(::round(start_y * inv_y));
+        double k = static_cast<int>(::round(start_z * inv_z));
+
+        int step_x = (dx[b] >= 0) ? 1 : -1;
+        int step_y = (dy[b] >= 0) ? 1 : -1;
+        int step_z = (dz[b] >= 0) ? 1 : -1;
+        double voxel_max_x = b_min_x + (leaf_x * 0.5f) +
+                             (static_cast<float>(static_cast<int>(i - min_x)) * leaf_x);
+        double voxel_max_y = b_min_y + (leaf_y * 0.5f) +
+                             (static_cast<float>(static_cast<int>(j - min_y)) * leaf_y);
+        double voxel_max_z = b_min_z + (leaf_z * 0.5f) +
+                             (static_cast<float>(static_cast<int>(k - min_z)) * leaf_z);
+        voxel_max_x += step_x * (leaf_x * 0.5f);
+        voxel_max_y += step_y * (leaf_y * 0.5f);
+        voxel_max_z += step_z * (leaf_z * 0.5f);
+
+        float t_max_x = t_min + (voxel_max_x - start_x) / dx[b];
+        float t_max_y = t_min + (voxel_max_y - start_y) / dy[b];
+        float t_max_z = t_min + (voxel_max_z - start_z) / dz[b];
+        float t_delta_x = leaf_x / static_cast<float>(fabs(dx[b]));
+        float t_delta_y = leaf_y / static_cast<float>(fabs(dy[b]));
+        float t_delta_z = leaf_z / static_cast<float>(fabs(dz[b]));
+
+        // the point is occluded by an occupied voxel more than two voxels from its own
+        bool occluded = false;
+        while ((i <= max_x + 1) && (i + 1 >= min_x) && (j <= max_y + 1) && (j + 1 >= min_y) &&
+               (k <= max_z + 1) && (k + 1 >= min_z))
+        {
+            if (ti[b] == i && tj[b] == j && tk[b] == k)
+                break;
+            int idx = static_cast<int>((i - min_x) * mul_x + (j - min_y) * mul_y +
+                                       (k - min_z) * mul_z);
+            if (idx >= 0 && idx < layout_size && leaf_layout_[idx] != -1)
+            {
+                double vx = b_min_x + (leaf_x * 0.5f) +
+                            (static_cast<float>(static_cast<int>(i - min_x)) * leaf_x);
+                double vy = b_min_y + (leaf_y * 0.5f) +
+                            (static_cast<float>(static_cast<int>(j - min_y)) * leaf_y);
+                double vz = b_min_z + (leaf_z * 0.5f) +
+                            (static_cast<float>(static_cast<int>(k - min_z)) * leaf_z);
+                double dist = sqrt((vx - cx[b]) * (vx - cx[b]) + (vy - cy[b]) * (vy - cy[b]) +
+                                   (vz - cz[b]) * (vz - cz[b]));
+                if (dist > leaf_x * 2)
+                {
+                    occluded = true;
+                    break;
+                }
+            }
+
+            // estimate next voxel
+            if (t_max_x <= t_max_y && t_max_x <= t_max_z)
+            {
+                t_max_x += t_delta_x;
+                i += step_x;
+            }
+            else if (t_max_y <= t_max_z && t_max_y <= t_max_x)
+            {
+                t_max_y += t_delta_y;
+                j += step_y;
+            }
+            else
+            {
+                t_max_z += t_delta_z;
+                k += step_z;
+            }
+        }
+        if (occluded)
+            continue;
+
+        double norm = (max_acc - depth_acc[b]) / max_acc;
+        free_states_[begin + b] = 1;
+        free_entropies_[begin + b] =
+            static_cast<float>(-1 * norm * log(norm) - ((1 - norm) * log(1 - norm)));
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT>
 float pcl::VoxelGridOcclusionEstimationT<PointInT>::rayBoxIntersection(
@@ -324,103 +776,103 @@ int pcl::VoxelGridOcclusionEstimationT<PointInT>::rayTraversal(const Eigen::Vect
                                                                const Eigen::Vector4f& origin,
                                                                const Eigen::Vector4f& direction,
                                                                const float t_min)
+{
+    RayState ray;
+    initializeRay(ray, target_voxel, origin, direction, t_min);
+
+    int state = -1;
+    while (state == -1)
+        state = advanceRay(ray);
+    return state;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelGridOcclusionEstimationT<PointInT>::initializeRay(RayState& ray,
+                                                                 const Eigen::Vector3i& target_voxel,
+                                                                 const Eigen::Vector4f& origin,
+                                                                 const Eigen::Vector4f& direction,
+                                                                 const float t_min)
 {
     // coordinate of the boundary of the voxel grid
     Eigen::Vector4f start = origin + t_min * direction;
 
     // i,j,k coordinate of the voxel were the ray enters the voxel grid
-    Eigen::Vector3i ijk = getGridCoordinatesRound(start[0], start[1], start[2]);
-
-    // steps in which direction we have to travel in the voxel grid
-    int step_x, step_y, step_z;
+    Eigen::Vector3i ijk = getRayStartVoxel(start, t_min);
 
     // centroid coordinate of the entry voxel
     Eigen::Vector4f voxel_max = getCentroidCoordinate(ijk);
 
-    if (direction[0] >= 0)
-    {
-        voxel_max[0] += leaf_size_[0] * 0.5f;
-        step_x = 1;
-    }
-    else
-    {
-        voxel_max[0] -= leaf_size_[0] * 0.5f;
-        step_x = -1;
-    }
-    if (direction[1] >= 0)
-    {
-        voxel_max[1] += leaf_size_[1] * 0.5f;
-        step_y = 1;
-    }
-    else
-    {
-        voxel_max[1] -= leaf_size_[1] * 0.5f;
-        step_y = -1;
-    }
-    if (direction[2] >= 0)
-    {
-        voxel_max[2] += leaf_size_[2] * 0.5f;
-        step_z = 1;
-    }
-    else
-    {
-        voxel_max[2] -= leaf_size_[2] * 0.5f;
-        step_z = -1;
-    }
-
-    float t_max_x = t_min + (voxel_max[0] - start[0]) / direction[0];
-    float t_max_y = t_min + (voxel_max[1] - start[1]) / direction[1];
-    float t_max_z = t_min + (voxel_max[2] - start[2]) / direction[2];
-
-    float t_delta_x = leaf_size_[0] / static_cast<float>(fabs(direction[0]));
-    float t_delta_y = leaf_size_[1] / static_cast<float>(fabs(direction[1]));
-    float t_delta_z = leaf_size_[2] / static_cast<float>(fabs(direction[2]));
-
-    // index of the point in the point cloud
-    int index;
-    //TODO: there is a rounding error at the max where the ijk values are rounded up , while the max_b is rounded down !
-    //Info: I added the <= as temp workaround
-    while ((ijk[0] <= max_b_[0] + 1) && (ijk[0] >= min_b_[0]) && (ijk[1] <= max_b_[1] + 1) &&
-           (ijk[1] >= min_b_[1]) && (ijk[2] <= max_b_[2] + 1) && (ijk[2] >= min_b_[2]))
+    // steps in which direction we have to travel in the voxel grid
+    for (int d = 0; d < 3; ++d)
     {
-        // check if we reached target voxel
-        if (ijk[0] == target_voxel[0] && ijk[1] == target_voxel[1] && ijk[2] == target_voxel[2])
-            return 0;
-      
-        // check if voxel is occupied
-        index = this->getCentroidIndexAt(ijk);
-        if (index != -1)
-        {
-            /*
-                When we iterate through points and not voxels, multiple points might be in the same voxel and simply checking
-                if the voxel is occupied is not enough as it will incorrectly report that it's occupied. We have to check that 
-                the distance between the occupied voxel and target is larger than the diagonal distance between 
-                voxels = leaf_size_[0]*2.0f*1.4142135f (1.4142135f = sqrt(2))
-            */
-            Eigen::Vector4f here   = getCentroidCoordinate (ijk);
-            Eigen::Vector4f target = getCentroidCoordinate (target_voxel);
-            double dist            = sqrt((here[0] -target[0])*(here[0] -target[0]) + (here[1] -target[1])*(here[1] -target[1]) +(here[2] -target[2])*(here[2] -target[2]));
-            if(dist>leaf_size_[0]*2.0f*1.4142135f)
-                return 1;
-        }
-        // estimate next voxel
-        if (t_max_x <= t_max_y && t_max_x <= t_max_z)
-        {
-            t_max_x += t_delta_x;
-            ijk[0] += step_x;
-        }
-        else if (t_max_y <= t_max_z && t_max_y <= t_max_x)
+        if (direction[d] >= 0)
         {
-            t_max_y += t_delta_y;
-            ijk[1] += step_y;
+            voxel_max[d] += leaf_size_[d] * 0.5f;
+            ray.step[d] = 1;
         }
         else
         {
-            t_max_z += t_delta_z;
-            ijk[2] += step_z;
+            voxel_max[d] -= leaf_size_[d] * 0.5f;
+            ray.step[d] = -1;
         }
+        ray.t_max[d] = t_min + (voxel_max[d] - start[d]) / direction[d];
+        ray.t_delta[d] = leaf_size_[d] / static_cast<float>(fabs(direction[d]));
+        ray.ijk[d] = ijk[d];
+        ray.target[d] = target_voxel[d];
     }
-    return 0;
+    ray.target_centroid = getCentroidCoordinate(target_voxel);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VoxelGridOcclusionEstimationT<PointInT>::advanceRay(RayState& ray)
+{
+    //TODO: there is a rounding error at the max where the ijk values are rounded up , while the max_b is rounded down !
+    //Info: I added the <= as temp workaround
+    if (!((ray.ijk[0] <= max_b_[0] + 1) && (ray.ijk[0] >= min_b_[0]) &&
+          (ray.ijk[1] <= max_b_[1] + 1) && (ray.ijk[1] >= min_b_[1]) &&
+          (ray.ijk[2] <= max_b_[2] + 1) && (ray.ijk[2] >= min_b_[2])))
+        return 0;
+
+    // check if we reached target voxel
+    if (ray.ijk[0] == ray.target[0] && ray.ijk[1] == ray.target[1] && ray.ijk[2] == ray.target[2])
+        return 0;
+
+    // check if voxel is occupied
+    Eigen::Vector3i ijk(ray.ijk[0], ray.ijk[1], ray.ijk[2]);
+    int index = this->getCentroidIndexAt(ijk);
+    if (index != -1)
+    {
+        /*
+            When we iterate through points and not voxels, multiple points might be in the same voxel and simply checking
+            if the voxel is occupied is not enough as it will incorrectly report that it's occupied. We have to check that 
+            the distance between the occupied voxel and target is larger than the diagonal distance between 
+            voxels = leaf_size_[0]*2.0f*1.4142135f (1.4142135f = sqrt(2))
+        */
+        Eigen::Vector4f here   = getCentroidCoordinate (ijk);
+        Eigen::Vector4f target = ray.target_centroid;
+        double dist            = sqrt((here[0] -target[0])*(here[0] -target[0]) + (here[1] -target[1])*(here[1] -target[1]) +(here[2] -target[2])*(here[2] -target[2]));
+        if(dist>leaf_size_[0]*2.0f*1.4142135f)
+            return 1;
+    }
+    // estimate next voxel
+    if (ray.t_max[0] <= ray.t_max[1] && ray.t_max[0] <= ray.t_max[2])
+    {
+        ray.t_max[0] += ray.t_delta[0];
+        ray.ijk[0] += ray.step[0];
+    }
+    else if (ray.t_max[1] <= ray.t_max[2] && ray.t_max[1] <= ray.t_max[0])
+    {
+        ray.t_max[1] += ray.t_delta[1];
+        ray.ijk[1] += ray.step[1];
+    }
+    else
+    {
+        ray.t_max[2] += ray.t_delta[2];
+        ray.ijk[2] += ray.step[2];
+    }
+    return -1;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -438,7 +890,7 @@ int pcl::VoxelGridOcclusionEstimationT<PointInT>::rayTraversal(
     Eigen::Vector4f start = origin + t_min * direction;
 
     // i,j,k coordinate of the voxel were the ray enters the voxel grid
-    Eigen::Vector3i ijk = getGridCoordinatesRound(start[0], start[1], start[2]);
+    Eigen::Vector3i ijk = getRayStartVoxel(start, t_min);
 
     // steps in which direction we have to travel in the voxel grid
     int step_x, step_y, step_z;
@@ -40,6 +40,7 @@
 
 #include <cuda_runtime.h>
 #include <pcl/filters/voxel_grid.h>
+#include <pcl/point_types.h>
 #define NUM_BLOCKS 64
 #define NUM_THREADS 1024
 
@@ -52,9 +53,12 @@ namespace pcl
     * \author Christian Potthast
     * \ingroup filters
     */
-template <typename PointInT>
-class VoxelGridOcclusionEstimationGPU : public VoxelGrid<PointInT>
+class VoxelGridOcclusionEstimationGPU : public VoxelGrid<pcl::PointXYZ>
 {
+  public:
+    // the kernels only copy the x, y, z coordinates to the device
+    typedef pcl::PointXYZ PointInT;
+
   protected:
     using VoxelGrid<PointInT>::min_b_;
     using VoxelGrid<PointInT>::max_b_;
@@ -62,9 +66,9 @@ class VoxelGridOcclusionEstimationGPU : public VoxelGrid<PointInT>
     using VoxelGrid<PointInT>::leaf_size_;
     using VoxelGrid<PointInT>::inverse_leaf_size_;
 
-    typedef typename Filter<PointInT>::PointCloud PointCloud;
-    typedef typename PointCloud::Ptr PointCloudPtr;
-    typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+    typedef Filter<PointInT>::PointCloud PointCloud;
+    typedef PointCloud::Ptr PointCloudPtr;
+    typedef PointCloud::ConstPtr PointCloudConstPtr;
 
   public:
     //occupancy probability
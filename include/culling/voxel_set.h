@@ -0,0 +1,143 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef VOXEL_SET_H_
+#define VOXEL_SET_H_
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+namespace pcl
+{
+/** \brief Set of the occupied voxels of a model, one bit per voxel id (the index of the voxel
+    * centroid in the filtered model cloud). Marking a voxel is a bit operation and the size of
+    * the set, or of its intersection with another set, is a popcount over 64-bit words.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::VoxelSet covered (num_model_voxels);
+    * covered.insert (voxel_id);
+    * float coverage = 100.0f * covered.count () / covered.capacity ();
+    * \endcode
+    *
+    * \ingroup filters
+    */
+class VoxelSet
+{
+  public:
+    /** \brief Empty constructor. */
+    VoxelSet() : capacity_(0)
+    {
+    }
+
+    /** \brief Creates an empty set over a number of voxel ids.
+        * \param[in] capacity the number of voxel ids
+        */
+    explicit VoxelSet(size_t capacity)
+    {
+        resize(capacity);
+    }
+
+    /** \brief Sets the number of voxel ids and removes all voxels from the set.
+        * \param[in] capacity the number of voxel ids
+        */
+    inline void resize(size_t capacity)
+    {
+        capacity_ = capacity;
+        words_.assign((capacity + 63) / 64, 0);
+    }
+
+    /** \brief Returns the number of voxel ids the set is defined over. */
+    inline size_t capacity() const
+    {
+        return (capacity_);
+    }
+
+    /** \brief Removes all voxels from the set. */
+    inline void clear()
+    {
+        std::fill(words_.begin(), words_.end(), 0);
+    }
+
+    /** \brief Adds a voxel to the set.
+        * \param[in] id the voxel id, smaller than capacity ()
+        */
+    inline void insert(size_t id)
+    {
+        words_[id >> 6] |= (uint64_t(1) << (id & 63));
+    }
+
+    /** \brief Removes a voxel from the set.
+        * \param[in] id the voxel id, smaller than capacity ()
+        */
+    inline void erase(size_t id)
+    {
+        words_[id >> 6] &= ~(uint64_t(1) << (id & 63));
+    }
+
+    /** \brief Returns true if a voxel is in the set.
+        * \param[in] id the voxel id, smaller than capacity ()
+        */
+    inline bool contains(size_t id) const
+    {
+        return ((words_[id >> 6] >> (id & 63)) & 1) != 0;
+    }
+
+    /** \brief Returns the number of voxels in the set. */
+    inline size_t count() const
+    {
+        size_t n = 0;
+        for (size_t w = 0; w < words_.size(); ++w)
+            n += __builtin_popcountll(words_[w]);
+        return (n);
+    }
+
+    /** \brief Returns the number of voxels in both sets.
+        * \param[in] other a set over the same voxel ids
+        */
+    inline size_t intersectionCount(const VoxelSet& other) const
+    {
+        size_t n = 0;
+        size_t num_words = std::min(words_.size(), other.words_.size());
+        for (size_t w = 0; w < num_words; ++w)
+            n += __builtin_popcountll(words_[w] & other.words_[w]);
+        return (n);
+    }
+
+    /** \brief Adds the voxels of another set.
+        * \param[in] other a set over the same voxel ids
+        */
+    inline void unite(const VoxelSet& other)
+    {
+        size_t num_words = std::min(words_.size(), other.words_.size());
+        for (size_t w = 0; w < num_words; ++w)
+            words_[w] |= other.words_[w];
+    }
+
+  protected:
+    // number of voxel ids and the bits of the set, 64 voxels per word
+    size_t capacity_;
+    std::vector<uint64_t> words_;
+};
+}  // namespace pcl
+#endif
@@ -0,0 +1,217 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef VOXELIZATION_ENGINE_H_
+#define VOXELIZATION_ENGINE_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <utility>
+#include <vector>
+
+namespace pcl
+{
+/** \brief Parallel voxelization of a point cloud with the bounds, voxel indices, leaf layout
+    * and centroids of pcl::VoxelGrid::applyFilter.
+    * The voxel keys are computed in blocks that the compiler can vectorize, the (key, point)
+    * pairs are grouped by a parallel LSD radix sort and the centroids are reduced per voxel in
+    * parallel. The radix sort is stable, so the points of a voxel are accumulated in the order
+    * of the indices.
+    *
+    * Code example:
+    *
+    * \code
+    * pcl::VoxelizationEngineT<PointInT> engine;
+    * engine.setInverseLeafSize (inverse_leaf_size);
+    * if (engine.voxelize (*cloud, indices) == 0)
+    * {
+    *   engine.computeLeafLayout (leaf_layout);
+    *   engine.computeCentroids (*cloud, true, output);
+    * }
+    * \endcode
+    *
+    * \ingroup filters
+    */
+template <typename PointInT>
+class VoxelizationEngineT
+{
+  public:
+    typedef pcl::PointCloud<PointInT> PointCloud;
+
+    /** \brief Empty constructor. */
+    VoxelizationEngineT() : min_points_per_voxel_(0)
+    {
+        inverse_leaf_size_.setOnes();
+        min_b_.setZero();
+        max_b_.setZero();
+        div_b_.setZero();
+        divb_mul_.setZero();
+    }
+
+    /** \brief Set the inverse of the voxel size, as stored by pcl::VoxelGrid.
+        * \param[in] inverse_leaf_size the inverse voxel size (x, y, z)
+        */
+    inline void setInverseLeafSize(const Eigen::Array4f& inverse_leaf_size)
+    {
+        inverse_leaf_size_ = inverse_leaf_size;
+    }
+
+    /** \brief Set the minimum number of points a voxel needs to be occupied.
+        * \param[in] min_points_per_voxel the minimum number of points
+        */
+    inline void setMinPointsPerVoxel(unsigned int min_points_per_voxel)
+    {
+        min_points_per_voxel_ = min_points_per_voxel;
+    }
+
+    /** \brief Computes the bounds of the grid and groups the finite points by voxel.
+        * \param[in] input the point cloud
+        * \param[in] indices the indices of the points to voxelize
+        * \return 0 on success, -1 if the integer voxel indices would overflow
+        */
+    int voxelize(const PointCloud& input, const std::vector<int>& indices);
+
+    /** \brief Fills a leaf layout over the grid with the centroid index of each voxel
+        * (-1 if not occupied).
+        * \param[out] leaf_layout the leaf layout
+        */
+    void computeLeafLayout(std::vector<int>& leaf_layout);
+
+    /** \brief Computes the centroid of every occupied voxel.
+        * \param[in] input the point cloud given to voxelize ()
+        * \param[in] downsample_all_data average all fields instead of x, y, z only
+        * \param[out] output the centroids, in the order of the voxel indices
+        */
+    void computeCentroids(const PointCloud& input, bool downsample_all_data, PointCloud& output);
+
+    /** \brief Allocates the buffers for up to num_points points, so that voxelizing no more
+        * points does not allocate.
+        * \param[in] num_points the largest number of points that will be voxelized
+        */
+    void reserve(size_t num_points);
+
+    /** \brief Returns the number of occupied voxels. */
+    inline size_t getNumberOfVoxels()
+    {
+        return (voxel_ranges_.size());
+    }
+
+    /** \brief Returns the minimum (i,j,k) voxel coordinates of the grid. */
+    inline const Eigen::Vector4i& getMinBoxCoordinates()
+    {
+        return (min_b_);
+    }
+
+    /** \brief Returns the maximum (i,j,k) voxel coordinates of the grid. */
+    inline const Eigen::Vector4i& getMaxBoxCoordinates()
+    {
+        return (max_b_);
+    }
+
+    /** \brief Returns the number of voxels of the grid along each axis. */
+    inline const Eigen::Vector4i& getNrDivisions()
+    {
+        return (div_b_);
+    }
+
+    /** \brief Returns the multipliers of (i,j,k) that give the voxel index. */
+    inline const Eigen::Vector4i& getDivisionMultiplier()
+    {
+        return (divb_mul_);
+    }
+
+    /** \brief Returns the (voxel index, point index) pairs sorted by voxel index. */
+    inline const std::vector<std::pair<unsigned int, unsigned int> >& getSortedIndices()
+    {
+        return (index_vector_);
+    }
+
+    /** \brief Returns the first and one past the last sorted pair of every occupied voxel. */
+    inline const std::vector<std::pair<unsigned int, unsigned int> >& getVoxelRanges()
+    {
+        return (voxel_ranges_);
+    }
+
+  protected:
+    /** \brief Sorts the pairs by voxel index with a parallel, stable LSD radix sort. */
+    void radixSort();
+
+    // The phases of voxelize () and radixSort (), run by every thread of a team on its share
+    // of the input, or by a single thread on all of it outside of a parallel region. The
+    // synchronisation between the phases stays in the parallel regions, since a barrier or
+    // single construct outside of them would bind to the team of the caller.
+
+    /** \brief Returns the range [begin, end) of a thread among size items. */
+    void getShare(int size, int thread, int threads, int& begin, int& end);
+
+    /** \brief Computes the bounding box and the number of finite points of a share. */
+    void computeShareBounds(const PointCloud& input, const std::vector<int>& indices, int thread,
+                            int threads, Eigen::Vector4f& local_min, Eigen::Vector4f& local_max);
+
+    /** \brief Computes the grid bounds from the bounding box of the points and the offsets of
+        * the pairs of every thread, returns false if the voxel indices would overflow.
+        */
+    bool computeGridBounds(const Eigen::Vector4f& min_p, const Eigen::Vector4f& max_p,
+                           int threads);
+
+    /** \brief Computes the (voxel index, point index) pairs of a share. */
+    void computeShareKeys(const PointCloud& input, const std::vector<int>& indices, int thread,
+                          int threads);
+
+    /** \brief Counts the digits of the pairs of a share. */
+    void computeShareHistogram(int shift, int thread, int threads);
+
+    /** \brief Turns the digit histograms of every thread into output offsets. */
+    void computeDigitOffsets(int threads);
+
+    /** \brief Moves the pairs of a share to the positions of their digit. */
+    void scatterShare(int shift, int thread, int threads);
+
+    /** \brief Computes the centroid of voxel cp, see computeCentroids (). */
+    void computeCentroid(const PointCloud& input, bool downsample_all_data, int cp,
+                         PointInT& centroid_point);
+
+    // number of points whose keys are computed together
+    static const int block_size_ = 64;
+
+    // digit width of the radix sort
+    static const int radix_bits_ = 8;
+    static const int radix_size_ = 1 << radix_bits_;
+
+    Eigen::Array4f inverse_leaf_size_;
+    unsigned int min_points_per_voxel_;
+    Eigen::Vector4i min_b_, max_b_, div_b_, divb_mul_;
+
+    // (voxel index, point index) pairs, the buffer of the radix sort and the voxel ranges
+    std::vector<std::pair<unsigned int, unsigned int> > index_vector_;
+    std::vector<std::pair<unsigned int, unsigned int> > sort_buffer_;
+    std::vector<std::pair<unsigned int, unsigned int> > voxel_ranges_;
+
+    // per thread digit histograms of the radix sort and point counts of the key computation
+    std::vector<size_t> histograms_;
+    std::vector<size_t> thread_counts_;
+
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+}  // namespace pcl
+#include "culling/voxelization_engine.hpp"
+#endif
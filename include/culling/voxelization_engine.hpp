@@ -0,0 +1,411 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#ifndef VOXELIZATION_ENGINE_HPP_
+#define VOXELIZATION_ENGINE_HPP_
+
+#include <culling/parallel_threads.h>
+#include <culling/voxelization_engine.h>
+#include <pcl/common/centroid.h>
+#include <pcl/common/common.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+int pcl::VoxelizationEngineT<PointInT>::voxelize(const PointCloud& input,
+                                                 const std::vector<int>& indices)
+{
+    int num_threads = getParallelThreads();
+    thread_counts_.assign(num_threads + 1, 0);
+
+    Eigen::Vector4f min_p, max_p;
+    min_p.setConstant(FLT_MAX);
+    max_p.setConstant(-FLT_MAX);
+    bool overflow = false;
+
+    // a single thread runs the phases on the whole input outside of a parallel region
+    if (num_threads > 1)
+    {
+#pragma omp parallel num_threads(num_threads)
+        {
+            int thread = 0;
+            int threads = 1;
+#ifdef _OPENMP
+            thread = omp_get_thread_num();
+            threads = omp_get_num_threads();
+#endif
+            Eigen::Vector4f local_min, local_max;
+            computeShareBounds(input, indices, thread, threads, local_min, local_max);
+#pragma omp critical
+            {
+                min_p = min_p.cwiseMin(local_min);
+                max_p = max_p.cwiseMax(local_max);
+            }
+#pragma omp barrier
+
+#pragma omp single
+            overflow = !computeGridBounds(min_p, max_p, threads);
+
+            if (!overflow)
+                computeShareKeys(input, indices, thread, threads);
+        }
+    }
+    else
+    {
+        computeShareBounds(input, indices, 0, 1, min_p, max_p);
+        overflow = !computeGridBounds(min_p, max_p, 1);
+        if (!overflow)
+            computeShareKeys(input, indices, 0, 1);
+    }
+
+    voxel_ranges_.clear();
+    if (overflow)
+    {
+        index_vector_.clear();
+        return -1;
+    }
+
+    radixSort();
+
+    // first and one past the last pair of every voxel with enough points
+    voxel_ranges_.reserve(index_vector_.size());
+    unsigned int index = 0;
+    while (index < index_vector_.size())
+    {
+        unsigned int i = index + 1;
+        while (i < index_vector_.size() && index_vector_[i].first == index_vector_[index].first)
+            ++i;
+        if (i - index >= min_points_per_voxel_)
+            voxel_ranges_.push_back(std::make_pair(index, i));
+        index = i;
+    }
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::reserve(size_t num_points)
+{
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+    index_vector_.reserve(num_points);
+    sort_buffer_.reserve(num_points);
+    voxel_ranges_.reserve(num_points);
+    histograms_.reserve(static_cast<size_t>(num_threads) * radix_size_);
+    thread_counts_.reserve(num_threads + 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::radixSort()
+{
+    // only the digits the largest voxel index uses are sorted
+    uint64_t max_key = static_cast<uint64_t>(div_b_[0]) * div_b_[1] * div_b_[2] - 1;
+    int num_passes = 0;
+    while (num_passes * radix_bits_ < 32 && (max_key >> (num_passes * radix_bits_)) != 0)
+        ++num_passes;
+    if (index_vector_.size() < 2)
+        return;
+
+    int num_threads = getParallelThreads();
+    histograms_.resize(static_cast<size_t>(num_threads) * radix_size_);
+    sort_buffer_.resize(index_vector_.size());
+
+    for (int pass = 0; pass < num_passes; ++pass)
+    {
+        const int shift = pass * radix_bits_;
+        if (num_threads > 1)
+        {
+#pragma omp parallel num_threads(num_threads)
+            {
+                int thread = 0;
+                int threads = 1;
+#ifdef _OPENMP
+                thread = omp_get_thread_num();
+                threads = omp_get_num_threads();
+#endif
+                computeShareHistogram(shift, thread, threads);
+#pragma omp barrier
+
+#pragma omp single
+                computeDigitOffsets(threads);
+
+                scatterShare(shift, thread, threads);
+            }
+        }
+        else
+        {
+            computeShareHistogram(shift, 0, 1);
+            computeDigitOffsets(1);
+            scatterShare(shift, 0, 1);
+        }
+        index_vector_.swap(sort_buffer_);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::getShare(int size, int thread, int threads, int& begin,
+                                                 int& end)
+{
+    // every thread works on a contiguous share, so that the pairs it writes follow the order of
+    // the input
+    begin = static_cast<int>(static_cast<int64_t>(size) * thread / threads);
+    end = static_cast<int>(static_cast<int64_t>(size) * (thread + 1) / threads);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::computeShareBounds(const PointCloud& input,
+                                                           const std::vector<int>& indices,
+                                                           int thread, int threads,
+                                                           Eigen::Vector4f& local_min,
+                                                           Eigen::Vector4f& local_max)
+{
+    bool check_finite = !input.is_dense;
+    int begin, end;
+    getShare(static_cast<int>(indices.size()), thread, threads, begin, end);
+
+    // bounding box and number of the finite points of the share
+    local_min.setConstant(FLT_MAX);
+    local_max.setConstant(-FLT_MAX);
+    size_t count = 0;
+    for (int i = begin; i < end; ++i)
+    {
+        const PointInT& point = input.points[indices[i]];
+        if (check_finite && !isFinite(point))
+            continue;
+        local_min = local_min.cwiseMin(point.getVector4fMap());
+        local_max = local_max.cwiseMax(point.getVector4fMap());
+        ++count;
+    }
+    thread_counts_[thread + 1] = count;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+bool pcl::VoxelizationEngineT<PointInT>::computeGridBounds(const Eigen::Vector4f& min_p,
+                                                          const Eigen::Vector4f& max_p,
+                                                          int threads)
+{
+    // Check that the leaf size is not too small, given the size of the data
+    int64_t dx = static_cast<int64_t>((max_p[0] - min_p[0]) * inverse_leaf_size_[0]) + 1;
+    int64_t dy = static_cast<int64_t>((max_p[1] - min_p[1]) * inverse_leaf_size_[1]) + 1;
+    int64_t dz = static_cast<int64_t>((max_p[2] - min_p[2]) * inverse_leaf_size_[2]) + 1;
+    if ((dx * dy * dz) > static_cast<int64_t>(std::numeric_limits<int32_t>::max()))
+        return (false);
+
+    // Compute the minimum and maximum bounding box values
+    for (int d = 0; d < 3; ++d)
+    {
+        min_b_[d] = static_cast<int>(floor(min_p[d] * inverse_leaf_size_[d]));
+        max_b_[d] = static_cast<int>(floor(max_p[d] * inverse_leaf_size_[d]));
+    }
+    div_b_ = max_b_ - min_b_ + Eigen::Vector4i::Ones();
+    div_b_[3] = 0;
+    divb_mul_ = Eigen::Vector4i(1, div_b_[0], div_b_[0] * div_b_[1], 0);
+
+    // offset of the pairs of every thread
+    for (int t = 0; t < threads; ++t)
+        thread_counts_[t + 1] += thread_counts_[t];
+    index_vector_.resize(thread_counts_[threads]);
+    return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::computeShareKeys(const PointCloud& input,
+                                                         const std::vector<int>& indices,
+                                                         int thread, int threads)
+{
+    bool check_finite = !input.is_dense;
+    int begin, end;
+    getShare(static_cast<int>(indices.size()), thread, threads, begin, end);
+
+    const float inverse_x = inverse_leaf_size_[0];
+    const float inverse_y = inverse_leaf_size_[1];
+    const float inverse_z = inverse_leaf_size_[2];
+    const float min_x = static_cast<float>(min_b_[0]);
+    const float min_y = static_cast<float>(min_b_[1]);
+    const float min_z = static_cast<float>(min_b_[2]);
+    const int mul_y = divb_mul_[1];
+    const int mul_z = divb_mul_[2];
+
+    float x[block_size_], y[block_size_], z[block_size_];
+    unsigned int ids[block_size_], keys[block_size_];
+    size_t out = thread_counts_[thread];
+    int i = begin;
+    while (i < end)
+    {
+        // gather the coordinates of a block of finite points
+        int n = 0;
+        for (; i < end && n < block_size_; ++i)
+        {
+            const PointInT& point = input.points[indices[i]];
+            if (check_finite && !isFinite(point))
+                continue;
+            x[n] = point.x;
+            y[n] = point.y;
+            z[n] = point.z;
+            ids[n] = static_cast<unsigned int>(indices[i]);
+            ++n;
+        }
+
+        // the voxel indices of a block are computed without branches
+#pragma omp simd
+        for (int b = 0; b < n; ++b)
+        {
+            int ijk0 = static_cast<int>(floorf(x[b] * inverse_x) - min_x);
+            int ijk1 = static_cast<int>(floorf(y[b] * inverse_y) - min_y);
+            int ijk2 = static_cast<int>(floorf(z[b] * inverse_z) - min_z);
+            keys[b] = static_cast<unsigned int>(ijk0 + ijk1 * mul_y + ijk2 * mul_z);
+        }
+
+        for (int b = 0; b < n; ++b)
+            index_vector_[out + b] = std::make_pair(keys[b], ids[b]);
+        out += n;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::computeShareHistogram(int shift, int thread, int threads)
+{
+    static const unsigned int radix_mask = radix_size_ - 1;
+    int begin, end;
+    getShare(static_cast<int>(index_vector_.size()), thread, threads, begin, end);
+
+    // digit histogram of the share of the thread
+    size_t* histogram = &histograms_[static_cast<size_t>(thread) * radix_size_];
+    std::fill(histogram, histogram + radix_size_, 0);
+    for (int i = begin; i < end; ++i)
+        ++histogram[(index_vector_[i].first >> shift) & radix_mask];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::computeDigitOffsets(int threads)
+{
+    // the pairs of a digit are placed in order of the threads, which keeps the sort stable
+    size_t offset = 0;
+    for (int d = 0; d < radix_size_; ++d)
+        for (int t = 0; t < threads; ++t)
+        {
+            size_t& bucket = histograms_[static_cast<size_t>(t) * radix_size_ + d];
+            size_t count = bucket;
+            bucket = offset;
+            offset += count;
+        }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::scatterShare(int shift, int thread, int threads)
+{
+    static const unsigned int radix_mask = radix_size_ - 1;
+    const std::pair<unsigned int, unsigned int>* src = &index_vector_[0];
+    std::pair<unsigned int, unsigned int>* dst = &sort_buffer_[0];
+    int begin, end;
+    getShare(static_cast<int>(index_vector_.size()), thread, threads, begin, end);
+
+    size_t* histogram = &histograms_[static_cast<size_t>(thread) * radix_size_];
+    for (int i = begin; i < end; ++i)
+        dst[histogram[(src[i].first >> shift) & radix_mask]++] = src[i];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::computeLeafLayout(std::vector<int>& leaf_layout)
+{
+    leaf_layout.assign(static_cast<size_t>(div_b_[0]) * div_b_[1] * div_b_[2], -1);
+    int num_voxels = static_cast<int>(voxel_ranges_.size());
+    int num_threads = getParallelThreads();
+    if (num_threads > 1)
+    {
+#pragma omp parallel for num_threads(num_threads)
+        for (int cp = 0; cp < num_voxels; ++cp)
+            leaf_layout[index_vector_[voxel_ranges_[cp].first].first] = cp;
+    }
+    else
+        for (int cp = 0; cp < num_voxels; ++cp)
+            leaf_layout[index_vector_[voxel_ranges_[cp].first].first] = cp;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::computeCentroids(const PointCloud& input,
+                                                         bool downsample_all_data,
+                                                         PointCloud& output)
+{
+    int num_voxels = static_cast<int>(voxel_ranges_.size());
+    output.points.resize(num_voxels);
+    output.width = static_cast<uint32_t>(num_voxels);
+    output.height = 1;
+    output.is_dense = true;
+
+    // the voxels are independent
+    int num_threads = getParallelThreads();
+    if (num_threads > 1)
+    {
+#pragma omp parallel for num_threads(num_threads)
+        for (int cp = 0; cp < num_voxels; ++cp)
+            computeCentroid(input, downsample_all_data, cp, output.points[cp]);
+    }
+    else
+        for (int cp = 0; cp < num_voxels; ++cp)
+            computeCentroid(input, downsample_all_data, cp, output.points[cp]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT>
+void pcl::VoxelizationEngineT<PointInT>::computeCentroid(const PointCloud& input,
+                                                        bool downsample_all_data, int cp,
+                                                        PointInT& centroid_point)
+{
+    unsigned int first_index = voxel_ranges_[cp].first;
+    unsigned int last_index = voxel_ranges_[cp].second;
+    if (!downsample_all_data)
+    {
+        Eigen::Vector4f centroid(Eigen::Vector4f::Zero());
+        for (unsigned int li = first_index; li < last_index; ++li)
+            centroid += input.points[index_vector_[li].second].getVector4fMap();
+        centroid /= static_cast<float>(last_index - first_index);
+        centroid_point.getVector4fMap() = centroid;
+    }
+    else
+    {
+        CentroidPoint<PointInT> centroid;
+        for (unsigned int li = first_index; li < last_index; ++li)
+            centroid.add(input.points[index_vector_[li].second]);
+        centroid.get(centroid_point);
+    }
+}
+
+#endif
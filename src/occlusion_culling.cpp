@@ -26,3 +26,6 @@
  ****************************************************************************************/
 #include "culling/occlusion_culling.h"
 #include "culling/occlusion_culling.hpp"
+
+template class OcclusionCulling<pcl::PointXYZ>;
+template class OcclusionCulling<pcl::PointXYZRGB>;
@@ -22,20 +22,27 @@
 
 #include "culling/occlusion_culling_gpu.h"
 
-OcclusionCullingGPU::OcclusionCullingGPU(ros::NodeHandle& n, std::string modelName)
-    : nh(n), model(modelName), fc(true)
+// the point type of the GPU filters, also for the return types defined below
+typedef OcclusionCullingGPU::PointInT PointInT;
+
+void OcclusionCullingGPU::initialize()
 {
-    fov_pub = n.advertise<visualization_msgs::MarkerArray>("fov", 10);
-    cloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    cloudCopy = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     filtered_cloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-
     occlusionFreeCloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     FrustumCloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    std::string path = ros::package::getPath("component_test");
-    pcl::io::loadPCDFile<PointInT>(path + "/src/pcd/" + model, *cloud);
+    cloudCopy = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     cloudCopy->points = cloud->points;
-    voxelRes = 0.5f;
+
+    // the same parameters and defaults as OcclusionCulling
+    double res;
+    nh.param<double>("voxel_res", res, 0.1);
+    voxelRes = static_cast<float>(res);
+    nh.param<double>("sensor_hor_fov", sensorHorFOV, 60.0);
+    nh.param<double>("sensor_ver_fov", sensorVerFOV, 45.0);
+    nh.param<double>("sensor_near_limit", sensorNearLimit, 0.5);
+    nh.param<double>("sensor_far_limit", sensorFarLimit, 8.0);
+    nh.param<std::string>("frame_id", frame_id, "world");
+
     OriginalVoxelsSize = 0.0;
     id = 0.0;
     viewEntropy = 0.0;
@@ -66,161 +73,48 @@ OcclusionCullingGPU::OcclusionCullingGPU(ros::NodeHandle& n, std::string modelNa
     voxelgrid.filter(*filtered_cloud);
 
     fc.initializeGPUPointData(cloud);
-    fc.setVerticalFOV(45);
-    fc.setHorizontalFOV(58);
-    fc.setNearPlaneDistance(0.7);
-    fc.setFarPlaneDistance(6.0);
+    fc.setVerticalFOV(sensorVerFOV);
+    fc.setHorizontalFOV(sensorHorFOV);
+    fc.setNearPlaneDistance(sensorNearLimit);
+    fc.setFarPlaneDistance(sensorFarLimit);
 
     AccuracyMaxSet = false;
 }
+
+OcclusionCullingGPU::OcclusionCullingGPU(ros::NodeHandle& n, std::string modelName)
+    : nh(n), model(modelName), fc(true)
+{
+    fov_pub = n.advertise<visualization_msgs::MarkerArray>("fov", 10);
+    cloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
+    std::string path = ros::package::getPath("component_test");
+    pcl::io::loadPCDFile<PointInT>(path + "/src/pcd/" + model, *cloud);
+    initialize();
+}
+
 OcclusionCullingGPU::OcclusionCullingGPU(ros::NodeHandle& n,
                                          pcl::PointCloud<PointInT>::Ptr& cloudPtr)
     : nh(n), fc(true)
 {
     fov_pub = n.advertise<visualization_msgs::MarkerArray>("fov", 10);
     cloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    cloudCopy = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    filtered_cloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-
-    occlusionFreeCloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    FrustumCloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
     cloud->points = cloudPtr->points;
-    cloudCopy->points = cloud->points;
-
-    voxelRes = 0.5;
-    frame_id = "world";
-    OriginalVoxelsSize = 0.0;
-    id = 0.0;
-    voxelFilterOriginal.setInputCloud(cloud);
-    voxelFilterOriginal.setLeafSize(voxelRes, voxelRes, voxelRes);
-    voxelFilterOriginal.initializeVoxelGrid();
-    min_b1 = voxelFilterOriginal.getMinBoxCoordinates();
-    max_b1 = voxelFilterOriginal.getMaxBoxCoordinates();
-    for (int kk = min_b1.z(); kk <= max_b1.z(); ++kk)
-    {
-        for (int jj = min_b1.y(); jj <= max_b1.y(); ++jj)
-        {
-            for (int ii = min_b1.x(); ii <= max_b1.x(); ++ii)
-            {
-                Eigen::Vector3i ijk1(ii, jj, kk);
-                int index1 = voxelFilterOriginal.getCentroidIndexAt(ijk1);
-                if (index1 != -1)
-                {
-                    OriginalVoxelsSize++;
-                }
-            }
-        }
-    }
-
-    pcl::VoxelGrid<PointInT> voxelgrid;
-    voxelgrid.setInputCloud(cloud);
-    voxelgrid.setLeafSize(0.5f, 0.5f, 0.5f);
-    voxelgrid.filter(*filtered_cloud);
-
-    fc.setInputCloud(cloud);
-    fc.setVerticalFOV(45);
-    fc.setHorizontalFOV(58);
-    fc.setNearPlaneDistance(0.7);
-    fc.setFarPlaneDistance(6.0);
-
-    AccuracyMaxSet = false;
+    initialize();
 }
 
 OcclusionCullingGPU::OcclusionCullingGPU(std::string modelName) : model(modelName), fc(true)
 {
     cloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    filtered_cloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    cloudCopy = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    FrustumCloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-
     std::string path = ros::package::getPath("component_test");
     pcl::io::loadPCDFile<PointInT>(path + "/src/pcd/" + model, *cloud);
-    cloudCopy->points = cloud->points;
-
-    voxelRes = 0.5f;
-    OriginalVoxelsSize = 0.0;
-    id = 0.0;
-    viewEntropy = 0.0;
-    voxelFilterOriginal.setInputCloud(cloud);
-    voxelFilterOriginal.setLeafSize(voxelRes, voxelRes, voxelRes);
-    voxelFilterOriginal.initializeVoxelGrid();
-    min_b1 = voxelFilterOriginal.getMinBoxCoordinates();
-    max_b1 = voxelFilterOriginal.getMaxBoxCoordinates();
-    for (int kk = min_b1.z(); kk <= max_b1.z(); ++kk)
-    {
-        for (int jj = min_b1.y(); jj <= max_b1.y(); ++jj)
-        {
-            for (int ii = min_b1.x(); ii <= max_b1.x(); ++ii)
-            {
-                Eigen::Vector3i ijk1(ii, jj, kk);
-                int index1 = voxelFilterOriginal.getCentroidIndexAt(ijk1);
-                if (index1 != -1)
-                {
-                    OriginalVoxelsSize++;
-                }
-            }
-        }
-    }
-    pcl::VoxelGrid<PointInT> voxelgrid;
-    voxelgrid.setInputCloud(cloud);
-    voxelgrid.setLeafSize(voxelRes, voxelRes, voxelRes);
-    voxelgrid.filter(*filtered_cloud);
-
-    fc.initializeGPUPointData(cloud);
-    fc.setVerticalFOV(45);
-    fc.setHorizontalFOV(58);
-    fc.setNearPlaneDistance(0.7);
-    fc.setFarPlaneDistance(6.0);
-
-    AccuracyMaxSet = false;
+    initialize();
 }
-OcclusionCullingGPU::OcclusionCullingGPU() : model(NULL), fc(true)
+
+OcclusionCullingGPU::OcclusionCullingGPU() : model("scaled_desktop.pcd"), fc(true)
 {
     cloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    filtered_cloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    cloudCopy = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-    FrustumCloud = pcl::PointCloud<PointInT>::Ptr(new pcl::PointCloud<PointInT>);
-
     std::string path = ros::package::getPath("component_test");
-    pcl::io::loadPCDFile<PointInT>(path + "/src/pcd/scaled_desktop.pcd", *cloud);
-    cloudCopy->points = cloud->points;
-
-    voxelRes = 0.5f;
-    OriginalVoxelsSize = 0.0;
-    id = 0.0;
-    viewEntropy = 0.0;
-    voxelFilterOriginal.setInputCloud(cloud);
-    voxelFilterOriginal.setLeafSize(voxelRes, voxelRes, voxelRes);
-    voxelFilterOriginal.initializeVoxelGrid();
-    min_b1 = voxelFilterOriginal.getMinBoxCoordinates();
-    max_b1 = voxelFilterOriginal.getMaxBoxCoordinates();
-    for (int kk = min_b1.z(); kk <= max_b1.z(); ++kk)
-    {
-        for (int jj = min_b1.y(); jj <= max_b1.y(); ++jj)
-        {
-            for (int ii = min_b1.x(); ii <= max_b1.x(); ++ii)
-            {
-                Eigen::Vector3i ijk1(ii, jj, kk);
-                int index1 = voxelFilterOriginal.getCentroidIndexAt(ijk1);
-                if (index1 != -1)
-                {
-                    OriginalVoxelsSize++;
-                }
-            }
-        }
-    }
-    pcl::VoxelGrid<PointInT> voxelgrid;
-    voxelgrid.setInputCloud(cloud);
-    voxelgrid.setLeafSize(voxelRes, voxelRes, voxelRes);
-    voxelgrid.filter(*filtered_cloud);
-
-    fc.initializeGPUPointData(cloud);
-    fc.setVerticalFOV(45);
-    fc.setHorizontalFOV(58);
-    fc.setNearPlaneDistance(0.7);
-    fc.setFarPlaneDistance(6.0);
-
-    AccuracyMaxSet = false;
+    pcl::io::loadPCDFile<PointInT>(path + "/src/pcd/" + model, *cloud);
+    initialize();
 }
 OcclusionCullingGPU::~OcclusionCullingGPU()
 {
@@ -240,18 +134,20 @@ bool OcclusionCullingGPU::contains(pcl::PointCloud<PointInT> c, PointInT p)
 //c2 the cloud that you want to compare with the original cloud in the occlusion culling
 pcl::PointCloud<PointInT> OcclusionCullingGPU::pointsDifference(pcl::PointCloud<PointInT> c2)
 {
+    // the points of c2 are hashed once instead of scanning c2 for every model point
     pcl::PointCloud<PointInT> inter;
-    pcl::PointCloud<PointInT>::iterator it = cloud->begin();
-    for (; it != cloud->end(); ++it)
-    {
-        if (!contains(c2, *it))
-            inter.push_back(*it);
-    }
-
+    pcl::pointsDifference(*cloud, c2, inter);
     return inter;
 }
 
 pcl::PointCloud<PointInT> OcclusionCullingGPU::extractVisibleSurface(geometry_msgs::Pose location)
+{
+    extractVisibleSurface(location, freeCloud);
+    return freeCloud;
+}
+
+void OcclusionCullingGPU::extractVisibleSurface(const geometry_msgs::Pose& location,
+                                                pcl::PointCloud<PointInT>& visibleCloud)
 {
     pcl::PointCloud<PointInT>::Ptr output(new pcl::PointCloud<PointInT>);
     Eigen::Matrix4f camera_pose;
@@ -305,7 +201,8 @@ pcl::PointCloud<PointInT> OcclusionCullingGPU::extractVisibleSurface(geometry_ms
     //    toc = ros::Time::now();
     //    double diff = toc.toSec() - tic.toSec();
     //    std::cout<<"\nProcessing Occlusuin culling on remaining points took:"<< diff <<" raytracing took:"<<timeOnRayTracing<<" percentage:"<<timeOnRayTracing*100.0f/diff;
-    return freeCloud;
+    if (&visibleCloud != &freeCloud)
+        visibleCloud = freeCloud;
 }
 
 float OcclusionCullingGPU::calcCoveragePercent(pcl::PointCloud<PointInT>::Ptr cloud_filtered)
@@ -387,8 +284,8 @@ double OcclusionCullingGPU::calcAvgAccuracy(pcl::PointCloud<PointInT> pointCloud
     avgAccuracy = errorSum / pointCloud.size();
     return avgAccuracy;
 }
-double OcclusionCullingGPU::calcAvgAccuracy(pcl::PointCloud<PointInT> pointCloud,
-                                            geometry_msgs::Pose cameraPose)
+double OcclusionCullingGPU::calcAvgAccuracy(const pcl::PointCloud<PointInT>& pointCloud,
+                                            const geometry_msgs::Pose& cameraPose)
 {
     double avgAccuracy;
     double pointError, val, errorSum = 0;
@@ -407,7 +304,8 @@ double OcclusionCullingGPU::calcAvgAccuracy(pcl::PointCloud<PointInT> pointCloud
     return avgAccuracy;
 }
 
-void OcclusionCullingGPU::SSMaxMinAccuracy(std::vector<geometry_msgs::PoseArray> sensorsPoses)
+void OcclusionCullingGPU::SSMaxMinAccuracy(
+    const std::vector<geometry_msgs::PoseArray>& sensorsPoses)
 {
     pcl::PointCloud<PointInT> global, globalVis;
     double max = 0, min = std::numeric_limits<double>::max();
@@ -553,6 +451,16 @@ pcl::PointCloud<PointInT> OcclusionCullingGPU::pointCloudViewportTransform(
     return posArray;
 }
 
+float OcclusionCullingGPU::getViewEntropy()
+{
+    return viewEntropy;
+}
+
+std::string OcclusionCullingGPU::getBackendName()
+{
+    return "accelerator";
+}
+
 void OcclusionCullingGPU::visualizeFOV(geometry_msgs::Pose location)
 {
     pcl::PointCloud<PointInT>::Ptr output(new pcl::PointCloud<PointInT>);
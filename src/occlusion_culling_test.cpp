@@ -22,6 +22,9 @@
 #include "tf/message_filter.h"
 #include "tf/transform_listener.h"
 //PCL
+// count the heap allocations of every query
+#define CULLING_ALLOCATION_HOOKS
+#include <culling/allocation_counter.h>
 #include <culling/occlusion_culling.h>
 #include <culling/utils.h>
 #include <pcl/common/eigen.h>
@@ -108,20 +111,17 @@ int main(int argc, char **argv)
     double locationx, locationy, locationz, yaw;
     geometry_msgs::PoseArray viewpoints;
     geometry_msgs::PoseStamped robotLocation;
-    double viewPointCount = 0;
-    double timeSum = 0;
 
     FILE *file = fopen(viewpointsFileStr.c_str(), "r");
     if (!file)
     {
         std::cout << "\nCan not open the File";
-        fclose(file);
+        return -1;
     }
 
     OcclusionCulling<pointType> occlusionCulling(nh, pcdFilePath);
-    while (!feof(file))
+    while (fscanf(file, "%lf %lf %lf %lf\n", &locationx, &locationy, &locationz, &yaw) == 4)
     {
-        fscanf(file, "%lf %lf %lf %lf\n", &locationx, &locationy, &locationz, &yaw);
         ROS_INFO("Robot location x,y,z:%f,%f,%f ", locationx, locationy, locationz);
 
         robotLocation.pose.position.x = locationx;
@@ -139,25 +139,43 @@ int main(int argc, char **argv)
         geometry_msgs::Pose sensorViewPointPose =
             uav2camTransformation(robotLocation.pose, sensorRPY2Robot, sensorXYZ2Robot);
         viewpoints.poses.push_back(sensorViewPointPose);
+    }
+    fclose(file);
 
-        PointCloud tempCloud;
-        ros::Time tic = ros::Time::now();
-
-        ///////////////////////////////////////////////////////////////
-        tempCloud = occlusionCulling.extractVisibleSurface(sensorViewPointPose);
-        frustumCloud = occlusionCulling.getFrustumCloud();
-        ////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////
+    pcl::VisibleSurfaceBatch batch = occlusionCulling.extractVisibleSurfaceBatch(viewpoints.poses);
+    ////////////////////////////////////////////////////////////////
 
-        ros::Time toc = ros::Time::now();
-        double elapsed = toc.toSec() - tic.toSec();
-        timeSum += elapsed;
-        ROS_INFO("Occulision Culling duration (s) = %f", elapsed);
+    int viewPointCount = static_cast<int>(batch.size());
+    double timeSum = 0;
+    double raysInFlightSum = 0;
+    pcl::LatencyStatistics latency(viewPointCount);
+    PointCloud tempCloud;
+    for (int v = 0; v < viewPointCount; v++)
+    {
+        timeSum += batch.latencies[v];
+        raysInFlightSum += batch.rayParallelism[v];
+        latency.add(batch.latencies[v]);
+        ROS_INFO("Occulision Culling duration (s) = %f, heap allocations:%d", batch.latencies[v],
+                 (int)batch.allocations[v]);
+        const pcl::ViewStatistics& stats = batch.viewStatistics[v];
+        ROS_INFO("Visible points:%d depth min:%f max:%f mean:%f, avg accuracy error:%f entropy:%f",
+                 (int)stats.getCount(), stats.getMinDepth(), stats.getMaxDepth(),
+                 stats.getMeanDepth(), stats.getAvgAccuracyError(), stats.getEntropy());
+        pcl::copyPointCloud(*occlusionCulling.cloud, batch.visibleIndices[v], tempCloud);
+        std::vector<int> newlyCovered;
+        occlusionCulling.addViewCoverage(tempCloud, newlyCovered);
         occludedCloud += tempCloud;
-        frustumCloud += frustumCloud;
-        viewPointCount++;
-        break;
+        pcl::copyPointCloud(*occlusionCulling.cloud, batch.frustumIndices[v], tempCloud);
+        frustumCloud += tempCloud;
     }
+    ROS_INFO("%d viewpoints on %d threads, viewpoints/s:%f", viewPointCount, batch.threads,
+             batch.getViewpointsPerSecond());
     ROS_INFO("On Average Occulision Culling takes (s) =%f", timeSum / viewPointCount);
+    ROS_INFO("On Average rays in flight (memory-level parallelism) =%f",
+             raysInFlightSum / viewPointCount);
+    ROS_INFO("Latency (s) p50:%f p99:%f p999:%f max:%f", latency.getPercentile(0.5),
+             latency.getPercentile(0.99), latency.getPercentile(0.999), latency.getMax());
     occludedCloudPtr->points = occludedCloud.points;
     frustumCloudPtr->points = frustumCloud.points;
 
@@ -0,0 +1,75 @@
+/***************************************************************************
+ *   Copyright (C) 2015 - 2017 by                                          *
+ *      Tarek Taha, KURI  <tataha@tarektaha.com>                           *
+ *      Randa Almadhoun   <randa.almadhoun@kustar.ac.ae>                   *
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Steet, Fifth Floor, Boston, MA  02111-1307, USA.          *
+ ***************************************************************************/
+#include "culling/point_set_operations.h"
+#include "culling/point_set_operations.hpp"
+
+namespace
+{
+/** \brief Marks the indices of a set in a mask over the points. */
+void markIndices(const std::vector<int>& indices, size_t num_points,
+                 std::vector<unsigned char>& mask)
+{
+    mask.assign(num_points, 0);
+    for (size_t i = 0; i < indices.size(); ++i)
+        mask[indices[i]] = 1;
+}
+
+/** \brief Appends the indices of a set whose mark is keep_marked to output. */
+void selectIndices(const std::vector<int>& indices, const std::vector<unsigned char>& mask,
+                   bool keep_marked, std::vector<int>& output)
+{
+    for (size_t i = 0; i < indices.size(); ++i)
+        if ((mask[indices[i]] != 0) == keep_marked)
+            output.push_back(indices[i]);
+}
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void pcl::indicesDifference(const std::vector<int>& indices_a, const std::vector<int>& indices_b,
+                            size_t num_points, std::vector<int>& output)
+{
+    std::vector<unsigned char> mask;
+    markIndices(indices_b, num_points, mask);
+    output.clear();
+    selectIndices(indices_a, mask, false, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void pcl::indicesIntersection(const std::vector<int>& indices_a,
+                              const std::vector<int>& indices_b, size_t num_points,
+                              std::vector<int>& output)
+{
+    std::vector<unsigned char> mask;
+    markIndices(indices_b, num_points, mask);
+    output.clear();
+    selectIndices(indices_a, mask, true, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void pcl::indicesUnion(const std::vector<int>& indices_a, const std::vector<int>& indices_b,
+                       size_t num_points, std::vector<int>& output)
+{
+    std::vector<unsigned char> mask;
+    markIndices(indices_a, num_points, mask);
+    output.assign(indices_a.begin(), indices_a.end());
+    selectIndices(indices_b, mask, false, output);
+}